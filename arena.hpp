@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace RandoRater {
+
+	const size_t kArenaBlockSize = 64 << 10;
+
+	//Bump allocator whose blocks are kept by Reset, so whatever is allocated from it again after the first few uses costs
+	//no heap allocation. Nothing is freed individually, everything allocated since the last Reset has to be dead by then
+	class Arena {
+	public:
+		Arena() {}
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		void* Allocate(size_t size, size_t alignment) {
+			while (true) {
+				if (block < blocks.size()) {
+					size_t begin = (used + alignment - 1) & ~(alignment - 1);
+					if (begin + size <= blocks[block].size) {
+						used = begin + size;
+						return blocks[block].data.get() + begin;
+					}
+					block++;
+					used = 0;
+					continue;
+				}
+				size_t block_size = std::max(kArenaBlockSize, size + alignment);
+				blocks.push_back({ std::unique_ptr<char[]>(new char[block_size]), block_size });
+			}
+		}
+
+		void Reset() {
+			block = 0;
+			used = 0;
+		}
+
+	private:
+		struct Block {
+			std::unique_ptr<char[]> data;
+			size_t size;
+		};
+
+		std::vector<Block> blocks;
+		size_t block = 0, used = 0;
+	};
+
+	//Allocates from an arena, or from the heap when default constructed, so containers that usually live on the heap can
+	//be pointed at an arena without changing their type
+	template <typename T>
+	struct ArenaAllocator {
+		typedef T value_type;
+		typedef std::true_type propagate_on_container_copy_assignment;
+		typedef std::true_type propagate_on_container_move_assignment;
+		typedef std::true_type propagate_on_container_swap;
+
+		Arena* arena = nullptr;
+
+		ArenaAllocator() {}
+		explicit ArenaAllocator(Arena* arena) : arena(arena) {}
+		template <typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+		T* allocate(size_t count) {
+			if (arena == nullptr) {
+				return static_cast<T*>(::operator new(count * sizeof(T)));
+			}
+			return static_cast<T*>(arena->Allocate(count * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T* data, size_t) {
+			if (arena == nullptr) {
+				::operator delete(data);
+			}
+		}
+
+		template <typename U>
+		bool operator==(const ArenaAllocator<U>& other) const {
+			return arena == other.arena;
+		}
+
+		template <typename U>
+		bool operator!=(const ArenaAllocator<U>& other) const {
+			return arena != other.arena;
+		}
+	};
+}
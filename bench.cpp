@@ -0,0 +1,818 @@
+#include <iostream>
+#include <fstream>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <filesystem>
+
+#include "pugixml.hpp"
+#include "compiledlogic.hpp"
+#include "mappedfile.hpp"
+#include "rater.hpp"
+#include "profiles.hpp"
+#include "specializedlogic.hpp"
+#include "whatif.hpp"
+
+//Every heap allocation of the program is counted, so the context phase can check that rating allocates nothing
+static std::atomic<uint64_t> bench_allocations(0);
+
+void* operator new(size_t size) {
+	bench_allocations.fetch_add(1, std::memory_order_relaxed);
+	void* data = malloc(size > 0 ? size : 1);
+	if (data == nullptr) {
+		throw std::bad_alloc();
+	}
+	return data;
+}
+
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void operator delete(void* data) noexcept {
+	free(data);
+}
+
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void operator delete(void* data, size_t) noexcept {
+	free(data);
+}
+
+//Benchmarks the rater on reproducible synthetic spoiler logs and checks their raw ratings against the golden file of the
+//evaluation mode, benchgolden.txt for fixpoint and benchgolden_recursive.txt for recursive and bitset. Run from the
+//repository root as
+//bench [--seeds N] [--first-seed S] [--reps N] [--warmup N] [--eval <mode>] [--json <path>] [--golden <path>] [--write-golden]
+//[--save-logs <dir>]
+namespace RandoRater {
+
+	const char* const kBenchGoldenPath = "benchgolden.txt";
+	const char* const kBenchRecursiveGoldenPath = "benchgolden_recursive.txt"; //bitset rates as recursive does
+
+	//splitmix64, so the same logs come out of every platform and standard library
+	struct BenchRandom {
+		uint64_t state;
+
+		explicit BenchRandom(uint64_t seed) : state(seed) {}
+
+		uint64_t Next() {
+			uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+
+		int Below(int n) {
+			return (int) (Next() % (uint64_t) n);
+		}
+
+		bool Chance() {
+			return (Next() >> 63) != 0;
+		}
+
+		template <typename T>
+		void Shuffle(std::vector<T>& values) {
+			for (int i = (int) values.size() - 1; i > 0; i--) {
+				std::swap(values[i], values[Below(i + 1)]);
+			}
+		}
+	};
+
+	struct BenchCheck {
+		std::string name;
+		std::string pool;
+		std::string area;
+		std::string cost_type;
+		int cost;
+		bool progression;
+	};
+
+	std::vector<BenchCheck> ReadBenchChecks(const std::string& path) {
+		pugi::xml_document doc;
+		if (!doc.load_file(path.c_str())) {
+			throw std::ios_base::failure("Unable to read file " + path);
+		}
+		std::vector<BenchCheck> checks;
+		for (pugi::xml_node item = doc.child("randomizer").first_child(); item; item = item.next_sibling()) {
+			std::string name = item.attribute("name").as_string();
+			if (name.empty()) {
+				continue;
+			}
+			checks.push_back({ name, item.child("pool").text().as_string(), item.child("areaName").text().as_string("Unknown"),
+				item.child("costType").text().as_string(), item.child("cost").text().as_int(), strcmp(item.child("progression").text().as_string(), "true") == 0 });
+		}
+		return checks;
+	}
+
+	struct BenchSources {
+		std::vector<BenchCheck> items, rocks, soul_lore;
+		std::vector<std::string> start_locations;
+	};
+
+	BenchSources ReadBenchSources() {
+		BenchSources sources;
+		sources.items = ReadBenchChecks("XML/items.xml");
+		sources.rocks = ReadBenchChecks("XML/rocks.xml");
+		sources.soul_lore = ReadBenchChecks("XML/soul_lore.xml");
+		for (auto& start_location : start_location_lookup) {
+			sources.start_locations.emplace_back(start_location.first);
+		}
+		std::sort(sources.start_locations.begin(), sources.start_locations.end()); //lookup iteration order is not portable
+		return sources;
+	}
+
+	std::string BenchLogName(std::string_view name) {
+		std::string res(name);
+		std::replace(res.begin(), res.end(), '_', ' ');
+		return res;
+	}
+
+	struct BenchPlacement {
+		const BenchCheck* item;
+		std::string location, area, cost_type;
+		int cost;
+	};
+
+	//Whether Radiance can be reached at all, ignoring difficulties, so the generator can skip logs that cannot be completed.
+	//Works from parsed.xml directly rather than the rater's compiled logic and evaluation, so it does not change with them
+	class BenchReachability {
+	public:
+		BenchReachability(const pugi::xml_document& parsed_logic_doc, const std::vector<ItemEffect>& catalog) {
+			for (pugi::xml_node macro = parsed_logic_doc.child("macros").child("macro"); macro; macro = macro.next_sibling("macro")) {
+				macros.push_back({ Intern(macro.attribute("name").as_string()), ReadLoadouts(macro) });
+			}
+			for (pugi::xml_node location = parsed_logic_doc.child("locations").child("location"); location; location = location.next_sibling("location")) {
+				location_loadouts[location.attribute("name").as_string()] = ReadLoadouts(location);
+			}
+			for (auto& macro : ignored_macros) {
+				ignored.push_back(Intern(macro));
+			}
+			for (auto& item : catalog) {
+				effects[item.name] = item;
+				if (item.chain >= 0) {
+					chains.resize(std::max((int) chains.size(), item.chain + 1));
+					chains[item.chain].resize(std::max((int) chains[item.chain].size(), item.level + 1));
+					chains[item.chain][item.level] = Intern(item.name);
+				}
+			}
+		}
+
+		bool Completable(const std::string& start_location, const std::vector<BenchPlacement>& placements, bool grubs, bool roots) {
+			struct Check {
+				int item;
+				const std::vector<std::vector<int>>* logic;
+				int grub_cost, essence_cost;
+				bool grub;
+				int essence;
+			};
+			std::vector<Check> checks;
+			auto add_check = [&](const std::string& item, const std::string& location, int grub_cost, int essence_cost) {
+				auto logic = location_loadouts.find(location);
+				if (logic == location_loadouts.end()) {
+					throw std::logic_error("Unknown location " + location);
+				}
+				auto effect = effects.find(item);
+				checks.push_back({ Intern(item), &logic->second, grub_cost, essence_cost, effect != effects.end() && effect->second.grub,
+					effect != effects.end() ? effect->second.essence : 0 });
+			};
+			for (auto& placement : placements) {
+				const std::string& item = placement.item->name;
+				if (placement.item->progression || misc_charms.count(item) || item.compare(0, 8, "Pale_Ore") == 0) { //what the rater reads
+					add_check(item, placement.location, placement.cost_type == "Grub" ? placement.cost : 0, placement.cost_type == "Essence" ? placement.cost : 0);
+				}
+			}
+			if (!grubs) {
+				for (auto& grub : default_grub_locations) {
+					add_check(std::string(grub), std::string(grub), 0, 0);
+				}
+			}
+			for (auto& essence_reward : default_essence_rewards) {
+				if (!roots || essence_reward.first.length() < 15) {
+					add_check(std::string(essence_reward.first), std::string(essence_reward.first), 0, 0);
+				}
+			}
+			const std::vector<std::vector<int>>& radiance = location_loadouts.at("Radiance");
+
+			have.assign(names.size(), 0);
+			for (int symbol : ignored) {
+				have[symbol] = 1;
+			}
+			have[Intern(start_location)] = 1;
+			int grub_count = 0, essence_count = 0;
+			std::vector<char> taken(checks.size(), 0);
+			while (true) {
+				Close();
+				if (Satisfied(radiance)) {
+					return true;
+				}
+				bool progress = false;
+				for (size_t c = 0; c < checks.size(); c++) {
+					if (taken[c] || grub_count < checks[c].grub_cost || essence_count < checks[c].essence_cost || !Satisfied(*checks[c].logic)) {
+						continue;
+					}
+					taken[c] = 1;
+					progress = true;
+					grub_count += checks[c].grub;
+					essence_count += checks[c].essence;
+					Acquire(checks[c].item);
+				}
+				if (!progress) {
+					return false;
+				}
+			}
+		}
+
+	private:
+		std::unordered_map<std::string, int> ids;
+		std::vector<std::string> names;
+		std::vector<std::pair<int, std::vector<std::vector<int>>>> macros;
+		std::unordered_map<std::string, std::vector<std::vector<int>>> location_loadouts;
+		std::vector<int> ignored;
+		std::unordered_map<std::string, ItemEffect> effects;
+		std::vector<std::vector<int>> chains;
+		std::vector<char> have;
+
+		int Intern(const std::string& name) {
+			auto inserted = ids.emplace(name, (int) names.size());
+			if (inserted.second) {
+				names.push_back(name);
+				have.push_back(0);
+			}
+			return inserted.first->second;
+		}
+
+		std::vector<std::vector<int>> ReadLoadouts(pugi::xml_node entry) {
+			std::vector<std::vector<int>> loadouts;
+			for (pugi::xml_node loadout = entry.child("loadout"); loadout; loadout = loadout.next_sibling("loadout")) {
+				loadouts.emplace_back();
+				std::string_view text = loadout.text().as_string(); //an empty loadout needs the symbol "", as it does for the rater
+				while (true) {
+					size_t end = text.find(" + ");
+					loadouts.back().push_back(Intern(std::string(text.substr(0, end))));
+					if (end == std::string_view::npos) {
+						break;
+					}
+					text.remove_prefix(end + 3);
+				}
+			}
+			return loadouts;
+		}
+
+		bool Satisfied(const std::vector<std::vector<int>>& loadouts) const {
+			return std::any_of(loadouts.begin(), loadouts.end(), [&](const std::vector<int>& loadout) {
+				return std::all_of(loadout.begin(), loadout.end(), [&](int symbol) { return have[symbol] != 0; });
+			});
+		}
+
+		void Close() {
+			for (bool changed = true; changed;) {
+				changed = false;
+				for (auto& macro : macros) {
+					if (!have[macro.first] && Satisfied(macro.second)) {
+						have[macro.first] = 1;
+						changed = true;
+					}
+				}
+			}
+		}
+
+		void Acquire(int item) {
+			for (auto& chain : chains) {
+				if (std::find(chain.begin(), chain.end(), item) != chain.end()) {
+					for (int level : chain) {
+						if (!have[level]) {
+							have[level] = 1;
+							return;
+						}
+					}
+					return;
+				}
+			}
+			have[item] = 1;
+		}
+	};
+
+	bool TryGenerateSpoilerLog(const BenchSources& sources, BenchReachability& reachability, uint64_t seed, BenchRandom& random, std::string& log) {
+		bool grubs = random.Chance(), roots = random.Chance(), rocks = random.Chance(), totems = random.Chance(), lore = random.Chance();
+		const std::string& start_location = sources.start_locations[random.Below((int) sources.start_locations.size())];
+
+		std::vector<const BenchCheck*> locations;
+		for (auto& check : sources.items) {
+			if (check.pool == "Fake" || check.pool == "Essence_Boss" || check.name.find('[') != std::string::npos || check.name.back() == ')'
+				|| (!grubs && check.pool == "Grub") || (!roots && check.pool == "Root")) {
+				continue;
+			}
+			locations.push_back(&check);
+		}
+		for (auto& check : sources.rocks) {
+			if (rocks) {
+				locations.push_back(&check);
+			}
+		}
+		for (auto& check : sources.soul_lore) {
+			if (check.pool == "Lore" ? lore : totems) {
+				locations.push_back(&check);
+			}
+		}
+
+		std::vector<const BenchCheck*> items = locations;
+		random.Shuffle(items);
+		std::vector<BenchPlacement> placements;
+		for (size_t i = 0; i < locations.size(); i++) {
+			placements.push_back({ items[i], locations[i]->name, locations[i]->area, locations[i]->cost_type, locations[i]->cost });
+		}
+		std::vector<const BenchCheck*> shop_items;
+		for (auto& check : sources.items) {
+			if (check.pool == "Relic" || check.pool == "Mask" || check.pool == "Vessel") {
+				shop_items.push_back(&check);
+			}
+		}
+		for (const char* shop : { "Sly", "Sly_(Key)", "Iselda", "Salubra", "Leg_Eater" }) {
+			placements.push_back({ shop_items[random.Below((int) shop_items.size())], shop, "Shops", "Geo", (random.Below(20) + 1) * 50 });
+		}
+
+		auto line = [](std::string& out, int n, const BenchPlacement& placement) {
+			out += "(" + std::to_string(n) + ") " + BenchLogName(placement.item->name) + "<---at--->" + placement.location;
+			if (placement.cost_type == "Grub" || placement.cost_type == "Essence" || placement.cost_type == "Geo") {
+				out += " [" + std::to_string(placement.cost) + " " + (placement.cost_type == "Grub" ? "Grubs" : placement.cost_type) + "]";
+			}
+			out += '\n';
+		};
+
+		if (!reachability.Completable(start_location_lookup.at(start_location), placements, grubs, roots)) {
+			return false;
+		}
+
+		log = "Randomization completed with seed: " + std::to_string(seed) + "\n\nPROGRESSION ITEMS\n";
+		std::vector<const BenchPlacement*> progression;
+		for (auto& placement : placements) {
+			if (placement.item->progression) {
+				progression.push_back(&placement);
+			}
+		}
+		random.Shuffle(progression);
+		int n = 1;
+		for (auto placement : progression) {
+			line(log, n++, *placement);
+		}
+
+		log += "\nALL ITEMS\n";
+		std::map<std::string, std::vector<const BenchPlacement*>> by_area;
+		for (auto& placement : placements) {
+			by_area[placement.area].push_back(&placement);
+		}
+		n = 1;
+		for (auto& area : by_area) {
+			log += BenchLogName(area.first) + ":\n";
+			for (auto placement : area.second) {
+				line(log, n++, *placement);
+			}
+			log += '\n';
+		}
+
+		auto setting = [&](const char* key, bool value) {
+			log += std::string(key) + ": " + (value ? "True" : "False") + "\n";
+		};
+		log += "SETTINGS\nSeed: " + std::to_string(seed) + "\nMode: Item Randomizer\nCursed: False\nStart location: " + start_location + "\n";
+		setting("Random start items", false);
+		log += "REQUIRED SKIPS\n";
+		for (const char* skip : { "Mild skips", "Shade skips", "Fireball skips", "Acid skips", "Spike tunnels", "Dark Rooms", "Spicy skips" }) {
+			setting(skip, false);
+		}
+		log += "RANDOMIZED LOCATIONS\n";
+		for (const char* pool : { "Dreamers", "Skills", "Charms", "Keys", "Mask shards", "Vessel fragments", "Pale ore", "Charm notches",
+			"Geo chests", "Rancid eggs", "Relics", "Stags", "Maps" }) {
+			setting(pool, true);
+		}
+		setting("Grubs", grubs);
+		setting("Whispering roots", roots);
+		setting("Geo rocks", rocks);
+		setting("Soul totems", totems);
+		setting("Palace totems", false);
+		setting("Lore tablets", lore);
+		setting("Duplicate major items", false);
+		log += "QUALITY OF LIFE\n";
+		setting("Grubfather", true);
+		return true;
+	}
+
+	//A spoiler log as written by the randomizer, with the items of every randomized pool shuffled across the locations of
+	//the same pools and a few relics sold in the shops. Grubs, whispering roots, geo rocks, soul totems and lore tablets
+	//are each randomized or not at random. Placements are redrawn until Radiance can be reached
+	std::string GenerateSpoilerLog(const BenchSources& sources, BenchReachability& reachability, uint64_t seed) {
+		BenchRandom random(seed);
+		std::string log;
+		while (!TryGenerateSpoilerLog(sources, reachability, seed, random, log)) {
+		}
+		return log;
+	}
+
+	struct BenchSeed {
+		uint64_t seed;
+		std::string log;
+		ParsedSpoilerLog parsed;
+		std::unordered_set<std::string> starting_items;
+		SeedRating rating;
+	};
+
+	class Timer {
+	public:
+		Timer() : start(std::chrono::steady_clock::now()) {}
+
+		double Microseconds() const {
+			return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+		}
+
+	private:
+		std::chrono::steady_clock::time_point start;
+	};
+
+	struct PhaseStats {
+		const char* name;
+		std::vector<double> samples = {}; //microseconds
+
+		double Percentile(double p) const { //nearest rank of the sorted samples
+			size_t rank = (size_t) std::max(1.0, std::ceil(p / 100 * samples.size()));
+			return samples[std::min(rank, samples.size()) - 1];
+		}
+
+		double Mean() const {
+			double sum = 0;
+			for (double sample : samples) {
+				sum += sample;
+			}
+			return sum / samples.size();
+		}
+	};
+
+	void WritePhaseJson(std::ostream& out, const PhaseStats& phase) {
+		out << "\"" << phase.name << "\":{\"samples\":" << phase.samples.size() << ",\"mean_us\":" << phase.Mean() << ",\"min_us\":" << phase.samples.front()
+			<< ",\"p50_us\":" << phase.Percentile(50) << ",\"p90_us\":" << phase.Percentile(90) << ",\"p99_us\":" << phase.Percentile(99)
+			<< ",\"max_us\":" << phase.samples.back() << "}";
+	}
+
+	struct GoldenRating {
+		std::string log_hash;
+		SeedRating rating;
+	};
+
+	std::string LogHash(const std::string& log) {
+		char hex[17];
+		snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) HashBytes(log.data(), log.length()));
+		return hex;
+	}
+
+	//One "seed log_hash raw_rating checks_taken" line per seed, lines starting with # are comments
+	std::map<uint64_t, GoldenRating> ReadGolden(const std::string& path) {
+		std::map<uint64_t, GoldenRating> golden;
+		std::ifstream in(path);
+		std::string line;
+		while (getline(in, line)) {
+			if (line.empty() || line[0] == '#') {
+				continue;
+			}
+			unsigned long long seed;
+			char hash[32];
+			long long raw;
+			int checks_taken;
+			if (sscanf(line.c_str(), "%llu %31s %lld %d", &seed, hash, &raw, &checks_taken) == 4) {
+				golden[seed] = { hash, { raw, checks_taken } };
+			}
+		}
+		return golden;
+	}
+
+	void WriteGolden(const std::string& path, const std::vector<BenchSeed>& seeds) {
+		std::ofstream out(path, std::ios::trunc);
+		out << "#seed log_hash raw_rating checks_taken, written by bench --write-golden\n";
+		for (auto& seed : seeds) {
+			out << seed.seed << ' ' << LogHash(seed.log) << ' ' << seed.rating.raw << ' ' << seed.rating.checks_taken << '\n';
+		}
+		if (!out) {
+			throw std::ios_base::failure("Unable to write " + path);
+		}
+	}
+
+	int main(int argc, char** argv) {
+		int seed_count = 200, repetitions = 3, warmup = 1;
+		uint64_t first_seed = 0;
+		const char* json_path = nullptr;
+		const char* save_logs = nullptr;
+		std::string golden_path;
+		bool write_golden = false;
+		EvaluationOptions evaluation_options;
+		for (int i = 1; i < argc; i++) {
+			if (strcmp(argv[i], "--seeds") == 0 && i + 1 < argc) {
+				seed_count = std::max(1, atoi(argv[++i]));
+			} else if (strcmp(argv[i], "--first-seed") == 0 && i + 1 < argc) {
+				first_seed = strtoull(argv[++i], nullptr, 10);
+			} else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+				repetitions = std::max(1, atoi(argv[++i]));
+			} else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+				warmup = std::max(0, atoi(argv[++i]));
+			} else if (strcmp(argv[i], "--eval") == 0 && i + 1 < argc) {
+				i++;
+				if (strcmp(argv[i], "fixpoint") == 0) {
+					evaluation_options.mode = EvaluationMode::kFixpoint;
+				} else if (strcmp(argv[i], "bitset") == 0) {
+					evaluation_options.mode = EvaluationMode::kBitset;
+				} else if (strcmp(argv[i], "recursive") == 0) {
+					evaluation_options.mode = EvaluationMode::kRecursive;
+				} else {
+					std::cout << "Unknown evaluation mode " << argv[i] << " (expected bitset, fixpoint or recursive)" << std::endl;
+					return 1;
+				}
+			} else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+				json_path = argv[++i];
+			} else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+				golden_path = argv[++i];
+			} else if (strcmp(argv[i], "--write-golden") == 0) {
+				write_golden = true;
+			} else if (strcmp(argv[i], "--save-logs") == 0 && i + 1 < argc) {
+				save_logs = argv[++i];
+			} else {
+				std::cout << "Usage: bench [--seeds N] [--first-seed S] [--reps N] [--warmup N] [--eval <mode>] [--json <path>] [--golden <path>] [--write-golden] [--save-logs <dir>]" << std::endl;
+				return 1;
+			}
+		}
+		if (golden_path.empty()) {
+			golden_path = evaluation_options.mode == EvaluationMode::kFixpoint ? kBenchGoldenPath : kBenchRecursiveGoldenPath;
+		}
+
+		MappedFile parsed_xml(kParsedLogicPath);
+		if (!parsed_xml) {
+			std::cout << "Unable to open " << kParsedLogicPath << std::endl;
+			return 1;
+		}
+		pugi::xml_document parsed_logic_doc;
+		if (!parsed_logic_doc.load_buffer(parsed_xml.data, parsed_xml.size)) {
+			std::cout << "Unable to parse " << kParsedLogicPath << std::endl;
+			return 1;
+		}
+		BenchReachability reachability(parsed_logic_doc, LoadItemCatalog(kAdditiveItemsPath, kItemsPath));
+		BenchSources sources = ReadBenchSources();
+		std::vector<BenchSeed> seeds(seed_count);
+		for (int s = 0; s < seed_count; s++) {
+			seeds[s].seed = first_seed + s;
+			seeds[s].log = GenerateSpoilerLog(sources, reachability, seeds[s].seed);
+		}
+		if (save_logs != nullptr) {
+			std::filesystem::create_directories(save_logs);
+			for (auto& seed : seeds) {
+				std::ofstream(std::filesystem::path(save_logs) / ("seed" + std::to_string(seed.seed) + ".txt"), std::ios::binary) << seed.log;
+			}
+		}
+
+		CompileOptions options = DefaultCompileOptions(true);
+		uint64_t source_hash = LogicSourceHash(parsed_xml.data, parsed_xml.size, options);
+
+		PhaseStats parse { "parse" }, build { "table_build" }, macros { "evaluate_macros" }, rate { "rate_progression" };
+		CompiledLogic logic;
+		for (int r = -warmup; r < repetitions; r++) {
+			bool record = r >= 0;
+			Timer build_timer;
+			pugi::xml_document build_doc;
+			if (!build_doc.load_buffer(parsed_xml.data, parsed_xml.size)) {
+				std::cout << "Unable to parse " << kParsedLogicPath << std::endl;
+				return 1;
+			}
+			logic = CompileLogic(build_doc, options, source_hash);
+			if (record) {
+				build.samples.push_back(build_timer.Microseconds());
+			}
+
+			for (auto& seed : seeds) {
+				Timer parse_timer;
+				seed.parsed = ParseSpoilerLog(seed.log);
+				if (record) {
+					parse.samples.push_back(parse_timer.Microseconds());
+				}
+				AddDefaultItems(seed.parsed);
+				seed.starting_items = { seed.parsed.settings.start_location };
+			}
+
+			//Every macro against the start location and every other placed item, as a fixed partway state
+			for (auto& seed : seeds) {
+				EvaluationState state(logic);
+				SymbolId start_location = logic.symbols.Find(seed.parsed.settings.start_location);
+				if (start_location != kNoSymbol) {
+					state.Acquire(start_location, 0);
+				}
+				bool acquire = false;
+				for (auto& item : seed.parsed.item_locations) {
+					SymbolId symbol = logic.symbols.Find(item.name);
+					if ((acquire = !acquire) && symbol != kNoSymbol) {
+						state.Acquire(symbol, 0);
+					}
+				}
+				Timer macro_timer;
+				if (evaluation_options.mode == EvaluationMode::kFixpoint) {
+					SolveMacros(logic, state);
+				} else {
+					for (SymbolId macro = 0; macro < logic.macro_count; macro++) {
+						EvaluateMacro(macro, logic, state);
+					}
+				}
+				if (record) {
+					macros.samples.push_back(macro_timer.Microseconds());
+				}
+			}
+
+			for (auto& seed : seeds) {
+				Timer rate_timer;
+				seed.rating = RateProgression(logic, seed.parsed.item_locations, seed.starting_items, evaluation_options);
+				if (record) {
+					rate.samples.push_back(rate_timer.Microseconds());
+				}
+			}
+		}
+
+		//Parsing and rating through one reused context, every seed once to grow its buffers and then once per repetition
+		//with every allocation counted
+		PhaseStats context_rate { "context_rate_seed" };
+		RaterContext context(logic);
+		uint64_t context_allocations = 0;
+		int context_mismatches = 0;
+		for (int r = -1; r < repetitions; r++) {
+			for (auto& seed : seeds) {
+				uint64_t allocations_before = bench_allocations.load();
+				Timer context_timer;
+				SeedRating rating = context.RateSeed(seed.log, evaluation_options);
+				double microseconds = context_timer.Microseconds();
+				if (r >= 0) {
+					context_allocations += bench_allocations.load() - allocations_before;
+					context_rate.samples.push_back(microseconds);
+				}
+				if (rating.raw != seed.rating.raw || rating.checks_taken != seed.rating.checks_taken) {
+					context_mismatches++;
+				}
+			}
+		}
+
+		//Rating over the logic specialized for each seed's start, once to specialize it and then once per repetition
+		PhaseStats specialized_rate { "specialized_rate" };
+		SpecializedLogicCache specialized_logic(logic);
+		SpecializedRater specialized(logic, specialized_logic);
+		int specialized_mismatches = 0;
+		for (int r = -1; r < repetitions; r++) {
+			for (auto& seed : seeds) {
+				Timer specialized_timer;
+				SeedRating rating = specialized.RateSeed(seed.log, evaluation_options);
+				if (r >= 0) {
+					specialized_rate.samples.push_back(specialized_timer.Microseconds());
+				}
+				if (rating.raw != seed.rating.raw || rating.checks_taken != seed.rating.checks_taken) {
+					specialized_mismatches++;
+				}
+			}
+		}
+		long long int specialized_loadouts = 0, specialized_symbols = 0;
+		for (auto& seed : seeds) {
+			const CompiledLogic& start_logic = *specialized_logic.Get(logic.symbols.Find(seed.parsed.settings.start_location));
+			specialized_loadouts += start_logic.location_logic.LoadoutCount() + start_logic.macro_logic.LoadoutCount();
+			specialized_symbols += start_logic.location_logic.symbols.size() + start_logic.macro_logic.symbols.size();
+		}
+
+		//Every seed for a group of profiles at once, the first of which is the default and has to rate like the fixpoint mode
+		PhaseStats profile_rate { "profile_rate_seed" };
+		std::vector<RatingProfile> profiles { ParseRatingProfile("default"), ParseRatingProfile("no_spicy=-SPICYSKIPS,-DARKROOMS"),
+			ParseRatingProfile("capped=5"), ParseRatingProfile("casual=2,-SPICYSKIPS,-SHADESKIPS,-FIREBALLSKIPS,-ACIDSKIPS") };
+		int profile_mismatches = 0, profile_lane_mismatches = 0;
+		for (int r = 0; r < repetitions; r++) {
+			for (auto& seed : seeds) {
+				Timer profile_timer;
+				std::vector<SeedRating> ratings = RateSeedProfiles(seed.log, logic, profiles);
+				profile_rate.samples.push_back(profile_timer.Microseconds());
+				if (evaluation_options.mode == EvaluationMode::kFixpoint
+					&& (ratings[0].raw != seed.rating.raw || ratings[0].checks_taken != seed.rating.checks_taken)) {
+					profile_mismatches++;
+				}
+				for (size_t k = 1; k < profiles.size() && r == 0; k++) { //every lane has to rate like its profile alone
+					SeedRating alone = RateSeedProfiles(seed.log, logic, { profiles[k] })[0];
+					if (ratings[k].raw != alone.raw || ratings[k].checks_taken != alone.checks_taken) {
+						profile_lane_mismatches++;
+					}
+				}
+			}
+		}
+
+		//Random swaps of two placements, each rated again from its last checkpoint and compared with rating from the start
+		PhaseStats swap_rate { "whatif_swap" };
+		const int kSwapsPerSeed = 32;
+		WhatIfRater whatif(logic);
+		int swap_mismatches = 0, reload_mismatches = 0;
+		for (int r = 0; r < repetitions; r++) {
+			BenchRandom random(first_seed + r);
+			for (auto& seed : seeds) {
+				std::vector<Placement> placements;
+				for (auto& item : seed.parsed.item_locations) {
+					placements.push_back(MakePlacement(logic, item));
+				}
+				std::vector<SymbolId> starting_symbols { logic.symbols.Find(seed.parsed.settings.start_location) };
+				whatif.Load(placements, starting_symbols);
+				whatif.Rating();
+				for (int swap = 0; swap < kSwapsPerSeed; swap++) {
+					int a = random.Below((int) placements.size()), b = random.Below((int) placements.size());
+					Timer swap_timer;
+					whatif.Swap(a, b);
+					SeedRating rating = whatif.Rating();
+					swap_rate.samples.push_back(swap_timer.Microseconds());
+					if (evaluation_options.mode == EvaluationMode::kFixpoint) {
+						SeedRating expected = context.RatePlacements(whatif.Placements(), starting_symbols, evaluation_options);
+						if (rating.raw != expected.raw || rating.checks_taken != expected.checks_taken) {
+							swap_mismatches++;
+						}
+					}
+				}
+				//Loading a seed with fewer placements into the same rater has to rate like a new rater
+				std::vector<Placement> fewer(placements.begin(), placements.begin() + std::min<size_t>(placements.size(), 20));
+				whatif.Load(fewer, starting_symbols);
+				WhatIfRater fresh(logic);
+				fresh.Load(fewer, starting_symbols);
+				SeedRating reloaded = whatif.Rating(), expected = fresh.Rating();
+				if (reloaded.raw != expected.raw || reloaded.checks_taken != expected.checks_taken) {
+					reload_mismatches++;
+				}
+			}
+		}
+
+		int golden_checked = 0, golden_mismatches = 0, golden_changed_logs = 0;
+		if (write_golden) {
+			WriteGolden(golden_path, seeds);
+			std::cout << "Wrote " << seeds.size() << " golden ratings to " << golden_path << std::endl;
+		} else {
+			std::map<uint64_t, GoldenRating> golden = ReadGolden(golden_path);
+			for (auto& seed : seeds) {
+				auto expected = golden.find(seed.seed);
+				if (expected == golden.end()) {
+					continue;
+				} else if (expected->second.log_hash != LogHash(seed.log)) { //generator or logic files changed since
+					golden_changed_logs++;
+					continue;
+				}
+				golden_checked++;
+				if (expected->second.rating.raw != seed.rating.raw || expected->second.rating.checks_taken != seed.rating.checks_taken) {
+					std::cout << "Mismatch seed " << seed.seed << ": raw rating " << seed.rating.raw << " (golden " << expected->second.rating.raw
+						<< "), checks taken " << seed.rating.checks_taken << " (golden " << expected->second.rating.checks_taken << ")" << std::endl;
+					golden_mismatches++;
+				}
+			}
+		}
+
+		PhaseStats* phases[] = { &parse, &build, &macros, &rate, &context_rate, &specialized_rate, &profile_rate, &swap_rate };
+		for (PhaseStats* phase : phases) {
+			std::sort(phase->samples.begin(), phase->samples.end());
+			printf("%-17s mean %10.1f us  p50 %10.1f  p90 %10.1f  p99 %10.1f  max %10.1f  (%zu samples)\n", phase->name, phase->Mean(),
+				phase->Percentile(50), phase->Percentile(90), phase->Percentile(99), phase->samples.back(), phase->samples.size());
+		}
+		int completable = (int) std::count_if(seeds.begin(), seeds.end(), [](const BenchSeed& seed) { return seed.rating.raw >= 0; });
+		std::cout << completable << " of " << seeds.size() << " seeds completable";
+		if (!write_golden) {
+			std::cout << ", " << golden_checked << " checked against " << golden_path << ", " << golden_mismatches << " mismatches";
+			if (golden_changed_logs > 0) {
+				std::cout << " (" << golden_changed_logs << " logs no longer match their golden hash)";
+			}
+		}
+		std::cout << std::endl;
+		std::cout << context_allocations << " allocations rating through a reused context after warmup, " << context_mismatches
+			<< " ratings differing from RateProgression" << std::endl;
+		std::cout << specialized_logic.size() << " start locations specialized, keeping "
+			<< 100.0 * specialized_loadouts / seeds.size() / (logic.location_logic.LoadoutCount() + logic.macro_logic.LoadoutCount()) << "% of loadouts and "
+			<< 100.0 * specialized_symbols / seeds.size() / (logic.location_logic.symbols.size() + logic.macro_logic.symbols.size()) << "% of their symbols, "
+			<< specialized_mismatches << " ratings differing from RateProgression" << std::endl;
+		std::cout << profiles.size() << " profiles rated in " << profile_rate.Mean() / context_rate.Mean() << " times the time of one, "
+			<< profile_mismatches << " default profile ratings differing from RateProgression, " << profile_lane_mismatches
+			<< " other profile ratings differing from rating the profile alone" << std::endl;
+		std::cout << (int) (1e6 / swap_rate.Mean()) << " swaps rated per second, " << swap_mismatches << " differing from rating from the start, "
+			<< reload_mismatches << " seeds rating differently after reloading a rater" << std::endl;
+
+		if (json_path != nullptr) {
+			std::ofstream json(json_path, std::ios::trunc);
+			json << "{\"seeds\":" << seeds.size() << ",\"first_seed\":" << first_seed << ",\"repetitions\":" << repetitions << ",\"warmup\":" << warmup
+				<< ",\"completable\":" << completable << ",\"phases\":{";
+			for (int p = 0; p < 8; p++) {
+				if (p > 0) {
+					json << ',';
+				}
+				WritePhaseJson(json, *phases[p]);
+			}
+			json << "},\"golden\":{\"checked\":" << golden_checked << ",\"mismatches\":" << golden_mismatches << ",\"changed_logs\":" << golden_changed_logs << "},\"context_allocations\":"
+				<< context_allocations << "}\n";
+		}
+		return golden_mismatches == 0 && context_allocations == 0 && context_mismatches == 0 && specialized_mismatches == 0 && profile_mismatches == 0 && profile_lane_mismatches == 0 && swap_mismatches == 0
+			&& reload_mismatches == 0 ? 0 : 1;
+	}
+}
+
+int main(int argc, char** argv) {
+	return RandoRater::main(argc, argv);
+}
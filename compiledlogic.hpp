@@ -0,0 +1,622 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdexcept>
+#include <ios>
+
+#include "pugixml.hpp"
+#include "itemcatalog.hpp"
+#include "loadoutmasks.hpp"
+#include "mappedfile.hpp"
+
+namespace RandoRater {
+
+	typedef int SymbolId;
+	const SymbolId kNoSymbol = -1;
+	const int kMaxDifficulty = 10;
+
+	inline uint64_t HashBytes(const void* data, size_t length, uint64_t hash = 14695981039346656037ull) { //FNV-1a
+		const unsigned char* bytes = (const unsigned char*) data;
+		for (size_t i = 0; i < length; i++) {
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	template <typename T>
+	struct ArrayView {
+		const T* data = nullptr;
+		int count = 0;
+
+		const T& operator[](int i) const {
+			return data[i];
+		}
+		int size() const {
+			return count;
+		}
+		const T* begin() const {
+			return data;
+		}
+		const T* end() const {
+			return data + count;
+		}
+	};
+
+	//Interned names: symbol i is blob[name_begin[i], name_begin[i + 1]) and slots is an open addressing hash table of ids
+	struct SymbolTable {
+		ArrayView<int> name_begin;
+		ArrayView<char> blob;
+		ArrayView<int> slots;
+
+		std::string_view Name(SymbolId id) const {
+			return std::string_view(blob.data + name_begin[id], name_begin[id + 1] - name_begin[id]);
+		}
+
+		SymbolId Find(std::string_view name) const {
+			if (slots.size() == 0) {
+				return kNoSymbol;
+			}
+			int mask = slots.size() - 1;
+			for (int slot = (int) (HashBytes(name.data(), name.length()) & mask); slots[slot] != kNoSymbol; slot = (slot + 1) & mask) {
+				if (Name(slots[slot]) == name) {
+					return slots[slot];
+				}
+			}
+			return kNoSymbol;
+		}
+
+		int size() const {
+			return name_begin.size() - 1;
+		}
+	};
+
+	//Loadouts of every entry stored flat: entry e owns loadouts [entry_begin[e], entry_begin[e + 1]),
+	//loadout l requires symbols [loadout_begin[l], loadout_begin[l + 1]) and has difficulty difficulties[l].
+	//The same symbols as a bitset are masks[l * mask_words, (l + 1) * mask_words)
+	struct LoadoutTable {
+		ArrayView<int> entry_begin;
+		ArrayView<int> loadout_begin;
+		ArrayView<SymbolId> symbols;
+		ArrayView<int> difficulties;
+		ArrayView<uint64_t> masks; //location loadouts only
+
+		int EntryCount() const {
+			return entry_begin.size() - 1;
+		}
+
+		int LoadoutCount() const {
+			return loadout_begin.size() - 1;
+		}
+	};
+
+	//Reverse of a LoadoutTable: the entries whose loadouts mention symbol s are entries[begin[s]], ..., entries[begin[s + 1] - 1]
+	struct DependentIndex {
+		ArrayView<int> begin;
+		ArrayView<int> entries;
+
+		const int* First(SymbolId symbol) const {
+			return symbol + 1 < begin.size() ? entries.data + begin[symbol] : nullptr;
+		}
+
+		const int* Last(SymbolId symbol) const {
+			return symbol + 1 < begin.size() ? entries.data + begin[symbol + 1] : nullptr;
+		}
+	};
+
+	//parsed.xml with every name interned. Macros take symbol ids [0, macro_count) so that macro_logic can be indexed by
+	//symbol id, items and other symbols only referenced by loadouts come after. Locations have their own id space since
+	//a location and the item found there frequently share a name (e.g. "Lurien").
+	//Everything is a view into one flat image (see LogicImageHeader), either built in memory or mapped from the cache file
+	struct CompiledLogic {
+		SymbolTable symbols;
+		SymbolTable locations;
+		int macro_count = 0;
+		ArrayView<char> ignored; //per symbol, always evaluates to 0
+		LoadoutTable macro_logic;
+		LoadoutTable location_logic;
+		DependentIndex macro_dependents; //macros mentioning each symbol
+		DependentIndex location_dependents; //locations mentioning each symbol
+		int mask_words = 0; //MaskWords of the symbol count
+		ArrayView<uint64_t> macro_mask; //bitset of the symbols that are macros
+		ArrayView<int> macro_order; //macros grouped by strongly connected component, every component after those it depends on
+		ArrayView<int> component_begin; //component c is macro_order[component_begin[c], component_begin[c + 1])
+		ArrayView<int> macro_component; //per macro
+		ArrayView<int> item_chain; //per symbol, additive group of the item or -1
+		ArrayView<char> item_grub; //per symbol
+		ArrayView<int> item_essence; //per symbol
+		ArrayView<int> chain_begin; //levels of additive group c, in order, are chain_levels[chain_begin[c], chain_begin[c + 1])
+		ArrayView<SymbolId> chain_levels;
+		uint64_t source_hash = 0;
+		const char* image = nullptr;
+		size_t image_size = 0;
+		std::shared_ptr<const void> storage; //keeps the image alive
+
+		bool IsMacro(SymbolId symbol) const {
+			return symbol >= 0 && symbol < macro_count;
+		}
+	};
+
+	struct CompileOptions {
+		std::vector<std::string> ignored_macros;
+		std::vector<std::string> tracked_items; //interned even if no loadout mentions them
+		std::vector<ItemEffect> items; //interned too, with their effects stored per symbol
+		std::string additive_path, items_path; //item catalog read into items by CompileLogic, the source hash covers their bytes
+		bool ignore_bad_difficulty = false;
+	};
+
+	const char kLogicImageMagic[8] = { 'R', 'R', 'L', 'O', 'G', 'I', 'C', '\0' };
+	const uint32_t kLogicImageVersion = 4;
+
+	enum LogicSection {
+		kSymbolNameBegin, kSymbolBlob, kSymbolSlots,
+		kLocationNameBegin, kLocationBlob, kLocationSlots,
+		kIgnored,
+		kMacroEntryBegin, kMacroLoadoutBegin, kMacroSymbols, kMacroDifficulties,
+		kLocationEntryBegin, kLocationLoadoutBegin, kLocationSymbols, kLocationDifficulties,
+		kMacroDependentBegin, kMacroDependents, kLocationDependentBegin, kLocationDependents,
+		kLocationMasks, kMacroMask,
+		kMacroOrder, kComponentBegin, kMacroComponent,
+		kItemChain, kItemGrub, kItemEssence, kChainBegin, kChainLevels,
+		kLogicSectionCount
+	};
+
+	//Image layout: this header, then every section 8-byte aligned. Integers are native endian since the image is only
+	//ever read back on the machine that wrote it
+	struct LogicImageHeader {
+		char magic[8];
+		uint32_t version;
+		int32_t macro_count;
+		uint64_t source_hash; //LogicSourceHash of the parsed.xml and options the image was compiled from
+		uint64_t size;
+		struct {
+			uint64_t offset, count;
+		} sections[kLogicSectionCount];
+	};
+
+	inline uint64_t LogicSourceHash(const char* parsed_xml, size_t length, const CompileOptions& options) {
+		uint64_t hash = HashBytes(&kLogicImageVersion, sizeof(kLogicImageVersion));
+		hash = HashBytes(parsed_xml, length, hash);
+		std::vector<std::string> ignored(options.ignored_macros);
+		std::sort(ignored.begin(), ignored.end());
+		const std::vector<std::string>* name_lists[] = { &ignored, &options.tracked_items };
+		for (auto* names : name_lists) {
+			for (auto& name : *names) {
+				hash = HashBytes(name.c_str(), name.length() + 1, hash);
+			}
+			hash = HashBytes("\n", 1, hash);
+		}
+		for (auto& item : options.items) {
+			int effect[4] = { item.chain, item.level, item.grub, item.essence };
+			hash = HashBytes(item.name.c_str(), item.name.length() + 1, hash);
+			hash = HashBytes(effect, sizeof(effect), hash);
+		}
+		if (!options.additive_path.empty()) { //hashed as they are, parsing them is left to a cache miss
+			for (auto& path : { options.additive_path, options.items_path }) {
+				MappedFile file(path);
+				if (!file) {
+					throw std::ios_base::failure("Unable to open " + path);
+				}
+				hash = HashBytes(file.data, file.size, hash);
+				hash = HashBytes("\n", 1, hash);
+			}
+		}
+		return HashBytes(&options.ignore_bad_difficulty, sizeof(bool), hash);
+	}
+
+	template <typename T>
+	bool ViewSection(const char* image, const LogicImageHeader& header, LogicSection section, ArrayView<T>& view) {
+		uint64_t offset = header.sections[section].offset, count = header.sections[section].count;
+		if (offset % alignof(T) != 0 || offset > header.size || count > (header.size - offset) / sizeof(T) || count > INT32_MAX) {
+			return false;
+		}
+		view.data = (const T*) (image + offset);
+		view.count = (int) count;
+		return true;
+	}
+
+	//Points a CompiledLogic at an image, returns false if the image is malformed or from another version
+	inline bool ViewLogicImage(const char* image, size_t size, std::shared_ptr<const void> storage, CompiledLogic& logic) {
+		if (size < sizeof(LogicImageHeader) || (uintptr_t) image % 8 != 0) {
+			return false;
+		}
+		const LogicImageHeader& header = *(const LogicImageHeader*) image;
+		if (memcmp(header.magic, kLogicImageMagic, sizeof(kLogicImageMagic)) != 0 || header.version != kLogicImageVersion || header.size != size) {
+			return false;
+		}
+		bool ok = ViewSection(image, header, kSymbolNameBegin, logic.symbols.name_begin)
+			&& ViewSection(image, header, kSymbolBlob, logic.symbols.blob)
+			&& ViewSection(image, header, kSymbolSlots, logic.symbols.slots)
+			&& ViewSection(image, header, kLocationNameBegin, logic.locations.name_begin)
+			&& ViewSection(image, header, kLocationBlob, logic.locations.blob)
+			&& ViewSection(image, header, kLocationSlots, logic.locations.slots)
+			&& ViewSection(image, header, kIgnored, logic.ignored)
+			&& ViewSection(image, header, kMacroEntryBegin, logic.macro_logic.entry_begin)
+			&& ViewSection(image, header, kMacroLoadoutBegin, logic.macro_logic.loadout_begin)
+			&& ViewSection(image, header, kMacroSymbols, logic.macro_logic.symbols)
+			&& ViewSection(image, header, kMacroDifficulties, logic.macro_logic.difficulties)
+			&& ViewSection(image, header, kLocationEntryBegin, logic.location_logic.entry_begin)
+			&& ViewSection(image, header, kLocationLoadoutBegin, logic.location_logic.loadout_begin)
+			&& ViewSection(image, header, kLocationSymbols, logic.location_logic.symbols)
+			&& ViewSection(image, header, kLocationDifficulties, logic.location_logic.difficulties)
+			&& ViewSection(image, header, kMacroDependentBegin, logic.macro_dependents.begin)
+			&& ViewSection(image, header, kMacroDependents, logic.macro_dependents.entries)
+			&& ViewSection(image, header, kLocationDependentBegin, logic.location_dependents.begin)
+			&& ViewSection(image, header, kLocationDependents, logic.location_dependents.entries)
+			&& ViewSection(image, header, kLocationMasks, logic.location_logic.masks)
+			&& ViewSection(image, header, kMacroMask, logic.macro_mask)
+			&& ViewSection(image, header, kMacroOrder, logic.macro_order)
+			&& ViewSection(image, header, kComponentBegin, logic.component_begin)
+			&& ViewSection(image, header, kMacroComponent, logic.macro_component)
+			&& ViewSection(image, header, kItemChain, logic.item_chain)
+			&& ViewSection(image, header, kItemGrub, logic.item_grub)
+			&& ViewSection(image, header, kItemEssence, logic.item_essence)
+			&& ViewSection(image, header, kChainBegin, logic.chain_begin)
+			&& ViewSection(image, header, kChainLevels, logic.chain_levels);
+		int symbol_count = logic.symbols.name_begin.size() - 1, mask_words = MaskWords(symbol_count);
+		ok = ok && symbol_count >= 0 && logic.locations.name_begin.size() >= 1
+			&& (logic.symbols.slots.size() & (logic.symbols.slots.size() - 1)) == 0
+			&& (logic.locations.slots.size() & (logic.locations.slots.size() - 1)) == 0
+			&& logic.ignored.size() == symbol_count
+			&& header.macro_count >= 0 && header.macro_count <= symbol_count
+			&& logic.macro_logic.entry_begin.size() == header.macro_count + 1
+			&& logic.location_logic.entry_begin.size() == logic.locations.name_begin.size()
+			&& logic.macro_dependents.begin.size() == symbol_count + 1
+			&& logic.location_dependents.begin.size() == symbol_count + 1
+			&& logic.location_logic.loadout_begin.size() >= 1
+			&& logic.location_logic.masks.size() == logic.location_logic.LoadoutCount() * mask_words
+			&& logic.macro_mask.size() == mask_words
+			&& logic.macro_order.size() == header.macro_count
+			&& logic.component_begin.size() >= 1
+			&& logic.macro_component.size() == header.macro_count
+			&& logic.item_chain.size() == symbol_count
+			&& logic.item_grub.size() == symbol_count
+			&& logic.item_essence.size() == symbol_count
+			&& logic.chain_begin.size() >= 1
+			&& logic.chain_levels.size() == logic.chain_begin[logic.chain_begin.size() - 1];
+		if (!ok) {
+			return false;
+		}
+		logic.macro_count = header.macro_count;
+		logic.mask_words = mask_words;
+		logic.source_hash = header.source_hash;
+		logic.image = image;
+		logic.image_size = size;
+		logic.storage = std::move(storage);
+		return true;
+	}
+
+	//Mutable tables used while compiling, flattened into an image once complete
+	struct SymbolTableBuilder {
+		std::unordered_map<std::string, SymbolId> ids;
+		std::vector<std::string> names;
+
+		SymbolId Intern(std::string_view name) {
+			auto iter = ids.find(std::string(name));
+			if (iter != ids.end()) {
+				return iter->second;
+			}
+			SymbolId id = (SymbolId) names.size();
+			names.push_back(std::string(name));
+			ids.insert(std::make_pair(names.back(), id));
+			return id;
+		}
+
+		SymbolId Find(const std::string& name) const {
+			auto iter = ids.find(name);
+			return iter == ids.end() ? kNoSymbol : iter->second;
+		}
+
+		int size() const {
+			return (int) names.size();
+		}
+	};
+
+	struct LoadoutTableBuilder {
+		std::vector<int> entry_begin { 0 };
+		std::vector<int> loadout_begin { 0 };
+		std::vector<SymbolId> symbols;
+		std::vector<int> difficulties;
+
+		int EntryCount() const {
+			return (int) entry_begin.size() - 1;
+		}
+	};
+
+	inline void CompileLoadouts(pugi::xml_node root, SymbolTableBuilder& names, SymbolTableBuilder& symbols, LoadoutTableBuilder& table,
+		bool ignore_bad_difficulty) {
+		for (auto entry = root.first_child(); entry; entry = entry.next_sibling()) {
+			std::string name = entry.attribute("name").as_string();
+			if (names.Find(name) != kNoSymbol) { //duplicate entry, first one wins
+				continue;
+			}
+			names.Intern(name);
+			for (auto loadout = entry.first_child(); loadout; loadout = loadout.next_sibling()) {
+				std::string_view logic = loadout.text().as_string();
+				size_t symbol_start = 0;
+				for (size_t i = 0; i < logic.length(); i++) {
+					if (logic[i] == '+') {
+						table.symbols.push_back(symbols.Intern(logic.substr(symbol_start, i - symbol_start - 1)));
+						symbol_start = i + 2;
+						i++;
+					}
+				}
+				table.symbols.push_back(symbols.Intern(logic.substr(symbol_start)));
+				int difficulty = loadout.attribute("difficulty").as_int();
+				if (difficulty < 0 && ignore_bad_difficulty) {
+					difficulty = 0;
+				}
+				if (difficulty < 0 || difficulty > kMaxDifficulty) {
+					std::string err_location = "parsed.xml -> " + std::string(root.name()) + " -> " + name + " -> loadout \"" + std::string(logic) + "\"";
+					throw std::logic_error("Difficulty must be between 0 and " + std::to_string(kMaxDifficulty) + ": " + err_location);
+				}
+				table.difficulties.push_back(difficulty);
+				table.loadout_begin.push_back((int) table.symbols.size());
+			}
+			table.entry_begin.push_back((int) table.difficulties.size());
+		}
+	}
+
+	inline std::vector<uint64_t> BuildLoadoutMasks(const LoadoutTableBuilder& table, int mask_words) {
+		std::vector<uint64_t> masks((table.loadout_begin.size() - 1) * mask_words, 0);
+		for (size_t l = 0; l + 1 < table.loadout_begin.size(); l++) {
+			for (int s = table.loadout_begin[l]; s < table.loadout_begin[l + 1]; s++) {
+				SetMaskBit(masks.data() + l * mask_words, table.symbols[s]);
+			}
+		}
+		return masks;
+	}
+
+	inline void BuildDependentIndex(const LoadoutTableBuilder& table, int symbol_count, std::vector<int>& begin, std::vector<int>& entries) {
+		std::vector<std::vector<int>> dependents(symbol_count);
+		for (int e = 0; e < table.EntryCount(); e++) {
+			for (int s = table.loadout_begin[table.entry_begin[e]]; s < table.loadout_begin[table.entry_begin[e + 1]]; s++) {
+				auto& list = dependents[table.symbols[s]];
+				if (list.empty() || list.back() != e) {
+					list.push_back(e);
+				}
+			}
+		}
+		begin.assign(1, 0);
+		entries.clear();
+		for (auto& list : dependents) {
+			entries.insert(entries.end(), list.begin(), list.end());
+			begin.push_back((int) entries.size());
+		}
+	}
+
+	//Tarjan's algorithm over the macro graph, a macro depending on the macros its loadouts mention. Components come out
+	//after every component they depend on, so evaluating them in order only ever needs finished components or members
+	//of the current one
+	struct MacroComponentBuilder {
+		const LoadoutTableBuilder& table;
+		std::vector<int> index, low_link, stack, order, component_begin { 0 }, component;
+		std::vector<char> on_stack;
+		int next_index = 0;
+
+		MacroComponentBuilder(const LoadoutTableBuilder& table, int macro_count) : table(table), index(macro_count, -1),
+			low_link(macro_count, 0), component(macro_count, -1), on_stack(macro_count, 0) {
+			for (int macro = 0; macro < macro_count; macro++) {
+				if (index[macro] < 0) {
+					Visit(macro);
+				}
+			}
+		}
+
+		void Visit(int macro) {
+			index[macro] = low_link[macro] = next_index++;
+			stack.push_back(macro);
+			on_stack[macro] = 1;
+			for (int s = table.loadout_begin[table.entry_begin[macro]]; s < table.loadout_begin[table.entry_begin[macro + 1]]; s++) {
+				int dependency = table.symbols[s];
+				if (dependency >= (int) index.size()) { //not a macro
+					continue;
+				} else if (index[dependency] < 0) {
+					Visit(dependency);
+					low_link[macro] = std::min(low_link[macro], low_link[dependency]);
+				} else if (on_stack[dependency]) {
+					low_link[macro] = std::min(low_link[macro], index[dependency]);
+				}
+			}
+			if (low_link[macro] == index[macro]) {
+				int member;
+				do {
+					member = stack.back();
+					stack.pop_back();
+					on_stack[member] = 0;
+					component[member] = (int) component_begin.size() - 1;
+					order.push_back(member);
+				} while (member != macro);
+				component_begin.push_back((int) order.size());
+			}
+		}
+	};
+
+	struct LogicImageWriter {
+		std::vector<char> bytes;
+
+		LogicImageWriter() : bytes(sizeof(LogicImageHeader), 0) {}
+
+		LogicImageHeader& Header() {
+			return *(LogicImageHeader*) bytes.data();
+		}
+
+		template <typename T>
+		void Append(LogicSection section, const T* data, size_t count) {
+			bytes.resize((bytes.size() + 7) / 8 * 8, 0);
+			Header().sections[section].offset = bytes.size();
+			Header().sections[section].count = count;
+			bytes.insert(bytes.end(), (const char*) data, (const char*) (data + count));
+		}
+
+		void AppendSymbols(const SymbolTableBuilder& table, LogicSection name_begin, LogicSection blob, LogicSection slots) {
+			std::vector<int> begin { 0 };
+			std::string names;
+			for (auto& name : table.names) {
+				names += name;
+				begin.push_back((int) names.length());
+			}
+			size_t slot_count = 1;
+			while (slot_count < table.names.size() * 2) {
+				slot_count *= 2;
+			}
+			std::vector<int> hash_slots(slot_count, kNoSymbol);
+			for (SymbolId id = 0; id < table.size(); id++) {
+				size_t slot = HashBytes(table.names[id].data(), table.names[id].length()) & (slot_count - 1);
+				while (hash_slots[slot] != kNoSymbol) {
+					slot = (slot + 1) & (slot_count - 1);
+				}
+				hash_slots[slot] = id;
+			}
+			Append(name_begin, begin.data(), begin.size());
+			Append(blob, names.data(), names.length());
+			Append(slots, hash_slots.data(), hash_slots.size());
+		}
+
+		template <typename T>
+		void Append(LogicSection section, const ArrayView<T>& view) {
+			Append(section, view.data, view.size());
+		}
+
+		void AppendLoadouts(const LoadoutTableBuilder& table, LogicSection entry_begin) {
+			Append(entry_begin, table.entry_begin.data(), table.entry_begin.size());
+			Append((LogicSection) (entry_begin + 1), table.loadout_begin.data(), table.loadout_begin.size());
+			Append((LogicSection) (entry_begin + 2), table.symbols.data(), table.symbols.size());
+			Append((LogicSection) (entry_begin + 3), table.difficulties.data(), table.difficulties.size());
+		}
+
+		//Both loadout tables and everything derived from them alone
+		void AppendLogic(const LoadoutTableBuilder& macro_logic, const LoadoutTableBuilder& location_logic, int symbol_count, int macro_count) {
+			AppendLoadouts(macro_logic, kMacroEntryBegin);
+			AppendLoadouts(location_logic, kLocationEntryBegin);
+			std::vector<int> begin, entries;
+			BuildDependentIndex(macro_logic, symbol_count, begin, entries);
+			Append(kMacroDependentBegin, begin.data(), begin.size());
+			Append(kMacroDependents, entries.data(), entries.size());
+			BuildDependentIndex(location_logic, symbol_count, begin, entries);
+			Append(kLocationDependentBegin, begin.data(), begin.size());
+			Append(kLocationDependents, entries.data(), entries.size());
+			int mask_words = MaskWords(symbol_count);
+			std::vector<uint64_t> masks = BuildLoadoutMasks(location_logic, mask_words);
+			Append(kLocationMasks, masks.data(), masks.size());
+			std::vector<uint64_t> macro_mask(mask_words, 0);
+			for (SymbolId macro = 0; macro < macro_count; macro++) {
+				SetMaskBit(macro_mask.data(), macro);
+			}
+			Append(kMacroMask, macro_mask.data(), macro_mask.size());
+			MacroComponentBuilder components(macro_logic, macro_count);
+			Append(kMacroOrder, components.order.data(), components.order.size());
+			Append(kComponentBegin, components.component_begin.data(), components.component_begin.size());
+			Append(kMacroComponent, components.component.data(), components.component.size());
+		}
+
+		CompiledLogic Finish(int macro_count, uint64_t source_hash) {
+			LogicImageHeader& header = Header();
+			memcpy(header.magic, kLogicImageMagic, sizeof(kLogicImageMagic));
+			header.version = kLogicImageVersion;
+			header.macro_count = macro_count;
+			header.source_hash = source_hash;
+			header.size = bytes.size();
+
+			auto storage = std::make_shared<std::vector<uint64_t>>((bytes.size() + 7) / 8);
+			memcpy(storage->data(), bytes.data(), bytes.size());
+			CompiledLogic logic;
+			if (!ViewLogicImage((const char*) storage->data(), bytes.size(), storage, logic)) {
+				throw std::logic_error("Compiled logic image is malformed");
+			}
+			return logic;
+		}
+	};
+
+	inline CompiledLogic CompileLogic(pugi::xml_document& parsed_logic_doc, const CompileOptions& options, uint64_t source_hash) {
+		SymbolTableBuilder symbols, macro_names, locations;
+		LoadoutTableBuilder macro_logic, location_logic;
+		pugi::xml_node macros = parsed_logic_doc.child("macros");
+		for (auto macro = macros.first_child(); macro; macro = macro.next_sibling()) {
+			symbols.Intern(macro.attribute("name").as_string());
+		}
+		int macro_count = symbols.size();
+
+		CompileLoadouts(macros, macro_names, symbols, macro_logic, options.ignore_bad_difficulty);
+		CompileLoadouts(parsed_logic_doc.child("locations"), locations, symbols, location_logic, options.ignore_bad_difficulty);
+
+		for (auto& item : options.tracked_items) {
+			symbols.Intern(item);
+		}
+		for (auto& macro : options.ignored_macros) {
+			symbols.Intern(macro);
+		}
+		std::vector<ItemEffect> items(options.items);
+		if (!options.additive_path.empty()) {
+			std::vector<ItemEffect> catalog = LoadItemCatalog(options.additive_path, options.items_path);
+			items.insert(items.end(), catalog.begin(), catalog.end());
+		}
+		for (auto& item : items) {
+			symbols.Intern(item.name);
+		}
+		std::vector<char> ignored(symbols.size(), 0);
+		for (auto& macro : options.ignored_macros) {
+			ignored[symbols.Find(macro)] = 1;
+		}
+
+		LogicImageWriter writer;
+		writer.AppendSymbols(symbols, kSymbolNameBegin, kSymbolBlob, kSymbolSlots);
+		writer.AppendSymbols(locations, kLocationNameBegin, kLocationBlob, kLocationSlots);
+		writer.Append(kIgnored, ignored.data(), ignored.size());
+		writer.AppendLogic(macro_logic, location_logic, symbols.size(), macro_count);
+		std::vector<int> item_chain(symbols.size(), -1), item_essence(symbols.size(), 0), chain_begin { 0 };
+		std::vector<char> item_grub(symbols.size(), 0);
+		std::vector<std::vector<std::pair<int, SymbolId>>> chains;
+		for (auto& item : items) {
+			SymbolId symbol = symbols.Find(item.name);
+			item_chain[symbol] = item.chain;
+			item_grub[symbol] = item.grub;
+			item_essence[symbol] = item.essence;
+			if (item.chain >= 0) {
+				chains.resize(std::max((int) chains.size(), item.chain + 1));
+				chains[item.chain].push_back(std::make_pair(item.level, symbol));
+			}
+		}
+		std::vector<SymbolId> chain_levels;
+		for (auto& chain : chains) {
+			std::sort(chain.begin(), chain.end());
+			for (auto& level : chain) {
+				chain_levels.push_back(level.second);
+			}
+			chain_begin.push_back((int) chain_levels.size());
+		}
+		writer.Append(kItemChain, item_chain.data(), item_chain.size());
+		writer.Append(kItemGrub, item_grub.data(), item_grub.size());
+		writer.Append(kItemEssence, item_essence.data(), item_essence.size());
+		writer.Append(kChainBegin, chain_begin.data(), chain_begin.size());
+		writer.Append(kChainLevels, chain_levels.data(), chain_levels.size());
+		return writer.Finish(macro_count, source_hash);
+	}
+
+	//logic with other loadouts and ignored symbols, keeping its symbols, locations and items (and so every id)
+	inline CompiledLogic RebuildLogic(const CompiledLogic& logic, const std::vector<char>& ignored, const LoadoutTableBuilder& macro_logic,
+		const LoadoutTableBuilder& location_logic, uint64_t source_hash) {
+		LogicImageWriter writer;
+		writer.Append(kSymbolNameBegin, logic.symbols.name_begin);
+		writer.Append(kSymbolBlob, logic.symbols.blob);
+		writer.Append(kSymbolSlots, logic.symbols.slots);
+		writer.Append(kLocationNameBegin, logic.locations.name_begin);
+		writer.Append(kLocationBlob, logic.locations.blob);
+		writer.Append(kLocationSlots, logic.locations.slots);
+		writer.Append(kIgnored, ignored.data(), ignored.size());
+		writer.AppendLogic(macro_logic, location_logic, logic.symbols.size(), logic.macro_count);
+		writer.Append(kItemChain, logic.item_chain);
+		writer.Append(kItemGrub, logic.item_grub);
+		writer.Append(kItemEssence, logic.item_essence);
+		writer.Append(kChainBegin, logic.chain_begin);
+		writer.Append(kChainLevels, logic.chain_levels);
+		return writer.Finish(logic.macro_count, source_hash);
+	}
+}
@@ -0,0 +1,422 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "compiledlogic.hpp"
+#include "mappedfile.hpp"
+#include "rater.hpp"
+
+//Seed corpus: many spoiler logs in one file, so rating a batch of them maps one file instead of opening thousands.
+//After the header come segments, each written by one pack or append: the logs and their tokens, then the segment's
+//string table, index and footer. Every footer points at the one of the segment before it, and the header holds the size
+//of the archive up to the latest footer, which is only updated once a segment is complete. Appending writes a new
+//segment after it, so earlier segments are never rewritten and an interrupted append leaves the archive as it was
+namespace RandoRater {
+
+	const char kSeedCorpusMagic[8] = { 'R', 'R', 'S', 'E', 'E', 'D', 'S', '\0' };
+	const char kSeedSegmentMagic[8] = { 'R', 'R', 'S', 'E', 'G', 'M', 'T', '\0' };
+	const uint32_t kSeedCorpusVersion = 1;
+
+	//Integers are native endian like the logic image, the corpus is meant for the machine that generated the seeds
+	struct SeedCorpusHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t reserved;
+		uint64_t committed_size; //up to the end of the latest complete segment
+	};
+
+	//Layout of a segment after its logs and tokens: the string table (4-byte aligned) as a count, count + 1 offsets into
+	//the string bytes and the bytes, then the index (8-byte aligned) and this footer, which ends the segment
+	struct SeedSegmentFooter {
+		char magic[8];
+		uint64_t previous_end; //end of the segment before, 0 for the first
+		uint64_t strings_offset;
+		uint64_t entries_offset;
+		uint32_t entry_count;
+		uint32_t reserved;
+		uint64_t index_hash; //HashBytes of everything from strings_offset up to the footer
+	};
+
+	//One log of the index. Names and tokens refer to strings of the segment's table
+	struct SeedCorpusEntry {
+		uint64_t text_offset, text_size; //size 0 if the text was dropped
+		uint64_t tokens_offset; //4-byte aligned
+		uint32_t token_count; //0 if the log was not tokenized
+		uint32_t name;
+	};
+
+	//Tokens of a log, all uint32_t: mode, flags (1 for randomized grubs, 2 for randomized roots), start location, start
+	//name, item count and transition count, then name, location, cost type and cost of every item in the order the
+	//rater places them, then both doors of every transition
+	const int kSeedTokenHeader = 6, kSeedItemTokens = 4, kSeedTransitionTokens = 2;
+
+	//A log read back from a corpus, kept by each rating thread so reading seed after seed reuses its buffers. Names are
+	//views into the mapped corpus
+	struct CorpusSeed {
+		std::string_view name;
+		std::string_view text; //empty if the text was dropped when packing
+		bool tokenized = false;
+		RandoSettings settings; //only when tokenized
+		std::vector<Item> items;
+		std::vector<std::pair<std::string_view, std::string_view>> transitions;
+	};
+
+	inline bool IsSeedCorpus(const std::string& path) {
+		std::ifstream file(path, std::ios::binary);
+		char magic[sizeof(kSeedCorpusMagic)];
+		return file.read(magic, sizeof(magic)) && memcmp(magic, kSeedCorpusMagic, sizeof(magic)) == 0;
+	}
+
+	//Spoiler logs of a directory (searched recursively, sorted by path) or of a file listing one path per line
+	inline std::vector<std::string> GetBatchPaths(const std::string& batch) {
+		std::vector<std::string> paths;
+		if (std::filesystem::is_directory(batch)) {
+			for (auto& entry : std::filesystem::recursive_directory_iterator(batch)) {
+				if (entry.is_regular_file()) {
+					paths.push_back(entry.path().string());
+				}
+			}
+			std::sort(paths.begin(), paths.end());
+		} else {
+			std::ifstream list(batch);
+			if (!list) {
+				throw std::ios_base::failure("Unable to open " + batch);
+			}
+			std::string path;
+			while (getline(list, path)) {
+				if (!path.empty() && path.back() == '\r') {
+					path.pop_back();
+				}
+				if (!path.empty()) {
+					paths.push_back(path);
+				}
+			}
+		}
+		return paths;
+	}
+
+	//Read-only view of a mapped corpus, every segment in the order they were written. Thread safe
+	class SeedCorpus {
+	public:
+		explicit SeedCorpus(const std::string& path) {
+			if (!file.Open(path)) {
+				throw std::ios_base::failure("Unable to open " + path);
+			}
+			if (!ViewSegments()) {
+				throw std::logic_error("Malformed seed corpus " + path);
+			}
+		}
+
+		SeedCorpus(const SeedCorpus&) = delete;
+		SeedCorpus& operator=(const SeedCorpus&) = delete;
+
+		int size() const {
+			return (int) entries.size();
+		}
+
+		std::string_view Name(int index) const {
+			return segments[entries[index].segment].strings[entries[index].entry->name];
+		}
+
+		//Throws if the tokens refer to strings the segment does not have
+		void Read(int index, CorpusSeed& seed) const {
+			const SeedCorpusEntry& entry = *entries[index].entry;
+			const std::vector<std::string_view>& strings = segments[entries[index].segment].strings;
+			seed.name = strings[entry.name];
+			seed.text = std::string_view(file.data + entry.text_offset, entry.text_size);
+			seed.tokenized = entry.token_count > 0;
+			seed.items.clear();
+			seed.transitions.clear();
+			if (!seed.tokenized) {
+				return;
+			}
+			const uint32_t* tokens = (const uint32_t*) (file.data + entry.tokens_offset);
+			auto string = [&](uint32_t id) {
+				if (id >= strings.size()) {
+					throw std::logic_error("Bad tokens for " + std::string(seed.name));
+				}
+				return strings[id];
+			};
+			uint64_t item_count = tokens[4], transition_count = tokens[5];
+			if (entry.token_count != kSeedTokenHeader + item_count * kSeedItemTokens + transition_count * kSeedTransitionTokens
+				|| tokens[0] > (uint32_t) RandoMode::kRoom) {
+				throw std::logic_error("Bad tokens for " + std::string(seed.name));
+			}
+			seed.settings.mode = (RandoMode) tokens[0];
+			seed.settings.randomized_grubs = (tokens[1] & 1) != 0;
+			seed.settings.randomized_roots = (tokens[1] & 2) != 0;
+			seed.settings.start_location = string(tokens[2]);
+			seed.settings.start_name = string(tokens[3]);
+			const uint32_t* item = tokens + kSeedTokenHeader;
+			for (uint64_t i = 0; i < item_count; i++, item += kSeedItemTokens) {
+				Item res(string(item[0]), string(item[1]));
+				res.cost_type = item[2] <= (uint32_t) ItemCost::kOther ? (ItemCost) item[2] : ItemCost::kOther;
+				res.cost = (int) item[3];
+				seed.items.push_back(res);
+			}
+			for (uint64_t t = 0; t < transition_count; t++, item += kSeedTransitionTokens) {
+				seed.transitions.push_back(std::make_pair(string(item[0]), string(item[1])));
+			}
+		}
+
+	private:
+		struct Segment {
+			std::vector<std::string_view> strings;
+		};
+		struct IndexedEntry {
+			const SeedCorpusEntry* entry;
+			int segment;
+		};
+
+		MappedFile file;
+		std::vector<Segment> segments;
+		std::vector<IndexedEntry> entries;
+
+		//Walks the footers back from the committed end, checking every offset against the segment it is in
+		bool ViewSegments() {
+			if (file.size < sizeof(SeedCorpusHeader)) {
+				return false;
+			}
+			const SeedCorpusHeader& header = *(const SeedCorpusHeader*) file.data;
+			if (memcmp(header.magic, kSeedCorpusMagic, sizeof(kSeedCorpusMagic)) != 0 || header.version != kSeedCorpusVersion
+				|| header.committed_size > file.size) {
+				return false;
+			}
+			std::vector<std::pair<uint64_t, uint64_t>> bounds; //begin and end of every segment, latest first
+			for (uint64_t end = header.committed_size; end > sizeof(SeedCorpusHeader);) {
+				if (end % 8 != 0 || end < sizeof(SeedCorpusHeader) + sizeof(SeedSegmentFooter)) {
+					return false;
+				}
+				const SeedSegmentFooter& footer = *(const SeedSegmentFooter*) (file.data + end - sizeof(SeedSegmentFooter));
+				uint64_t begin = std::max<uint64_t>(footer.previous_end, sizeof(SeedCorpusHeader));
+				if (memcmp(footer.magic, kSeedSegmentMagic, sizeof(kSeedSegmentMagic)) != 0 || footer.previous_end >= end) {
+					return false;
+				}
+				bounds.push_back(std::make_pair(begin, end));
+				end = footer.previous_end;
+			}
+			std::reverse(bounds.begin(), bounds.end());
+			for (auto& segment : bounds) {
+				if (!ViewSegment(segment.first, segment.second)) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool ViewSegment(uint64_t begin, uint64_t end) {
+			const SeedSegmentFooter& footer = *(const SeedSegmentFooter*) (file.data + end - sizeof(SeedSegmentFooter));
+			uint64_t footer_offset = end - sizeof(SeedSegmentFooter);
+			if (footer.strings_offset < begin || footer.strings_offset % 4 != 0 || footer.entries_offset % 8 != 0
+				|| footer.entries_offset > footer_offset || footer.strings_offset + sizeof(uint32_t) > footer.entries_offset
+				|| footer.entry_count > (footer_offset - footer.entries_offset) / sizeof(SeedCorpusEntry)
+				|| HashBytes(file.data + footer.strings_offset, footer_offset - footer.strings_offset) != footer.index_hash) {
+				return false;
+			}
+			const uint32_t* table = (const uint32_t*) (file.data + footer.strings_offset);
+			uint64_t string_count = table[0], bytes_offset = footer.strings_offset + (string_count + 2) * sizeof(uint32_t);
+			if (bytes_offset > footer.entries_offset) {
+				return false;
+			}
+			Segment segment;
+			for (uint64_t s = 0; s < string_count; s++) {
+				uint32_t string_begin = table[1 + s], string_end = table[2 + s];
+				if (string_begin > string_end || bytes_offset + string_end > footer.entries_offset) {
+					return false;
+				}
+				segment.strings.push_back(std::string_view(file.data + bytes_offset + string_begin, string_end - string_begin));
+			}
+			const SeedCorpusEntry* segment_entries = (const SeedCorpusEntry*) (file.data + footer.entries_offset);
+			for (uint32_t e = 0; e < footer.entry_count; e++) {
+				const SeedCorpusEntry& entry = segment_entries[e];
+				if (entry.name >= string_count || (entry.text_size > 0 && (entry.text_offset < begin || entry.text_size > footer.strings_offset - begin
+					|| entry.text_offset > footer.strings_offset - entry.text_size)) || entry.tokens_offset % 4 != 0
+					|| (entry.token_count > 0 && (entry.tokens_offset < begin || entry.token_count < kSeedTokenHeader
+						|| entry.token_count > (footer.strings_offset - entry.tokens_offset) / sizeof(uint32_t)))) {
+					return false;
+				}
+				entries.push_back(IndexedEntry { &entry, (int) segments.size() });
+			}
+			segments.push_back(std::move(segment));
+			return true;
+		}
+	};
+
+	//Writes one segment of a corpus, made by Commit. Logs added without a Commit are left out of the archive
+	class SeedCorpusWriter {
+	public:
+		//Creates the archive, or with append opens it to add a segment after its latest complete one
+		SeedCorpusWriter(const std::string& path, bool append) : path(path) {
+			if (append) {
+				SeedCorpusHeader header;
+				std::ifstream existing(path, std::ios::binary);
+				if (!existing.read((char*) &header, sizeof(header))) {
+					throw std::ios_base::failure("Unable to open " + path);
+				} else if (memcmp(header.magic, kSeedCorpusMagic, sizeof(kSeedCorpusMagic)) != 0 || header.version != kSeedCorpusVersion) {
+					throw std::logic_error(path + " is not a seed corpus");
+				}
+				existing.close();
+				previous_end = header.committed_size;
+				std::filesystem::resize_file(path, previous_end); //whatever an interrupted append left behind
+				out.open(path, std::ios::binary | std::ios::in | std::ios::out);
+				out.seekp(0, std::ios::end);
+			} else {
+				out.open(path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+				SeedCorpusHeader header = Header(sizeof(SeedCorpusHeader));
+				out.write((const char*) &header, sizeof(header));
+			}
+			if (!out) {
+				throw std::ios_base::failure("Unable to write " + path);
+			}
+			offset = (uint64_t) out.tellp();
+		}
+
+		SeedCorpusWriter(const SeedCorpusWriter&) = delete;
+		SeedCorpusWriter& operator=(const SeedCorpusWriter&) = delete;
+
+		//With tokenize the log is also stored parsed, with its items in the order the rater places them (which only
+		//depends on the standard library the writer was built with), so rating it skips parsing. Without keep_text only
+		//the tokens are stored. Returns false if the log could not be parsed, in which case its text is always kept and
+		//rating it reports the error
+		bool Add(const std::string& name, std::string_view text, bool tokenize, bool keep_text) {
+			SeedCorpusEntry entry = {};
+			entry.name = Intern(name);
+			bool tokenized = false;
+			if (tokenize) {
+				tokens.clear();
+				try {
+					Tokenize(text);
+					tokenized = true;
+				} catch (const std::exception&) {
+				}
+			}
+			if (keep_text || !tokenized) {
+				entry.text_offset = offset;
+				entry.text_size = text.length();
+				Write(text.data(), text.length());
+			}
+			if (tokenized) {
+				Pad(4);
+				entry.tokens_offset = offset;
+				entry.token_count = (uint32_t) tokens.size();
+				Write(tokens.data(), tokens.size() * sizeof(uint32_t));
+			}
+			entries.push_back(entry);
+			return tokenized;
+		}
+
+		//Writes the string table, index and footer, then points the header at the new end
+		void Commit() {
+			Pad(4);
+			SeedSegmentFooter footer = {};
+			memcpy(footer.magic, kSeedSegmentMagic, sizeof(kSeedSegmentMagic));
+			footer.previous_end = previous_end;
+			footer.strings_offset = offset;
+			std::vector<uint32_t> table(1, (uint32_t) strings.size());
+			uint32_t string_offset = 0;
+			table.push_back(0);
+			for (auto& str : strings) {
+				table.push_back(string_offset += (uint32_t) str.length());
+			}
+			uint64_t hash = HashBytes(table.data(), table.size() * sizeof(uint32_t));
+			Write(table.data(), table.size() * sizeof(uint32_t));
+			for (auto& str : strings) {
+				hash = HashBytes(str.data(), str.length(), hash);
+				Write(str.data(), str.length());
+			}
+			hash = HashBytes("\0\0\0\0\0\0\0", (8 - offset % 8) % 8, hash);
+			Pad(8);
+			footer.entries_offset = offset;
+			footer.entry_count = (uint32_t) entries.size();
+			footer.index_hash = HashBytes(entries.data(), entries.size() * sizeof(SeedCorpusEntry), hash);
+			Write(entries.data(), entries.size() * sizeof(SeedCorpusEntry));
+			Write(&footer, sizeof(footer));
+			out.flush();
+
+			SeedCorpusHeader header = Header(offset);
+			out.seekp(0);
+			out.write((const char*) &header, sizeof(header));
+			out.flush();
+			if (!out) {
+				throw std::ios_base::failure("Unable to write " + path);
+			}
+			out.seekp(0, std::ios::end);
+			previous_end = offset;
+			entries.clear();
+			strings.clear();
+			string_ids.clear();
+		}
+
+	private:
+		std::string path;
+		std::fstream out;
+		uint64_t offset = 0; //of the next byte written
+		uint64_t previous_end = 0;
+		std::vector<SeedCorpusEntry> entries;
+		std::vector<std::string> strings;
+		std::unordered_map<std::string, uint32_t> string_ids;
+		std::vector<uint32_t> tokens;
+		ParsedSpoilerLog parsed;
+
+		static SeedCorpusHeader Header(uint64_t committed_size) {
+			SeedCorpusHeader header = {};
+			memcpy(header.magic, kSeedCorpusMagic, sizeof(kSeedCorpusMagic));
+			header.version = kSeedCorpusVersion;
+			header.committed_size = committed_size;
+			return header;
+		}
+
+		uint32_t Intern(std::string_view str) {
+			auto res = string_ids.emplace(std::string(str), (uint32_t) strings.size());
+			if (res.second) {
+				strings.push_back(res.first->first);
+			}
+			return res.first->second;
+		}
+
+		//Same parse as RaterContext::ParseSeed
+		void Tokenize(std::string_view text) {
+			parsed.item_locations = ItemSet();
+			ParseSpoilerLog(text, parsed);
+			AddDefaultItems(parsed);
+			const RandoSettings& settings = parsed.settings;
+			tokens.push_back((uint32_t) settings.mode);
+			tokens.push_back((settings.randomized_grubs ? 1 : 0) | (settings.randomized_roots ? 2 : 0));
+			tokens.push_back(Intern(settings.start_location));
+			tokens.push_back(Intern(settings.start_name));
+			tokens.push_back((uint32_t) parsed.item_locations.size());
+			tokens.push_back((uint32_t) parsed.transitions.size());
+			for (auto& item : parsed.item_locations) { //iteration order of item_locations decides ties, so it is kept
+				tokens.push_back(Intern(item.name));
+				tokens.push_back(Intern(item.location));
+				tokens.push_back((uint32_t) item.cost_type);
+				tokens.push_back((uint32_t) item.cost);
+			}
+			for (auto& transition : parsed.transitions) {
+				tokens.push_back(Intern(transition.first));
+				tokens.push_back(Intern(transition.second));
+			}
+		}
+
+		void Write(const void* data, size_t length) {
+			out.write((const char*) data, length);
+			offset += length;
+		}
+
+		void Pad(uint64_t alignment) {
+			static const char zeros[8] = {};
+			Write(zeros, (alignment - offset % alignment) % alignment);
+		}
+	};
+}
@@ -0,0 +1,123 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <cstring>
+
+#include "pugixml.hpp"
+#include "corpus.hpp"
+
+//Packs spoiler logs into a seed corpus for main --batch, and back out of it:
+//corpustool pack|append <archive> <directory or list>... [--tokenize] [--drop-text]
+//corpustool unpack <archive> <directory>
+//corpustool list <archive>
+//Every input is a directory (searched recursively) or a file listing one spoiler log per line, as for --batch, and logs
+//keep the path they were read from as their name
+namespace RandoRater {
+
+	int Pack(const std::string& archive, const std::vector<std::string>& inputs, bool append, bool tokenize, bool keep_text) {
+		SeedCorpusWriter writer(archive, append);
+		int packed = 0, tokenized = 0, unreadable = 0;
+		for (auto& input : inputs) {
+			for (auto& path : GetBatchPaths(input)) {
+				std::unique_ptr<SpoilerLogText> spoiler_log;
+				try {
+					spoiler_log = ReadSpoilerLog(path);
+				} catch (const std::exception& e) {
+					std::cout << e.what() << std::endl;
+					unreadable++;
+					continue;
+				}
+				tokenized += writer.Add(path, spoiler_log->text, tokenize, keep_text) ? 1 : 0;
+				packed++;
+			}
+		}
+		writer.Commit();
+		std::cout << (append ? "Appended " : "Packed ") << packed << " spoiler logs to " << archive;
+		if (tokenize) {
+			std::cout << ", " << tokenized << " of them tokenized";
+		}
+		std::cout << std::endl;
+		return unreadable == 0 ? 0 : 1;
+	}
+
+	//Names become paths under directory, names that would leave it are skipped like logs stored without their text
+	int Unpack(const std::string& archive, const std::string& directory) {
+		SeedCorpus corpus(archive);
+		CorpusSeed seed;
+		int unpacked = 0, skipped = 0;
+		for (int i = 0; i < corpus.size(); i++) {
+			corpus.Read(i, seed);
+			std::filesystem::path name = std::filesystem::path(std::string(seed.name)).relative_path();
+			bool inside = !name.empty();
+			for (auto& part : name) {
+				inside = inside && part != "..";
+			}
+			if (!inside || (seed.text.empty() && seed.tokenized)) {
+				std::cout << "Skipped " << seed.name << (inside ? " (stored without its text)" : " (not a relative path)") << std::endl;
+				skipped++;
+				continue;
+			}
+			std::filesystem::path path = std::filesystem::path(directory) / name;
+			std::filesystem::create_directories(path.parent_path());
+			std::ofstream out(path, std::ios::binary | std::ios::trunc);
+			if (!out.write(seed.text.data(), seed.text.length())) {
+				throw std::ios_base::failure("Unable to write " + path.string());
+			}
+			unpacked++;
+		}
+		std::cout << "Unpacked " << unpacked << " spoiler logs to " << directory << std::endl;
+		return skipped == 0 ? 0 : 1;
+	}
+
+	int List(const std::string& archive) {
+		SeedCorpus corpus(archive);
+		CorpusSeed seed;
+		for (int i = 0; i < corpus.size(); i++) {
+			corpus.Read(i, seed);
+			std::cout << seed.name << '\t' << seed.text.length() << '\t' << (seed.tokenized ? "tokenized" : "text") << '\n';
+		}
+		std::cout << corpus.size() << " spoiler logs" << std::endl;
+		return 0;
+	}
+
+	int main(int argc, char** argv) {
+		std::vector<std::string> args;
+		bool tokenize = false, keep_text = true;
+		for (int i = 1; i < argc; i++) {
+			if (strcmp(argv[i], "--tokenize") == 0) {
+				tokenize = true;
+			} else if (strcmp(argv[i], "--drop-text") == 0) {
+				keep_text = false;
+			} else {
+				args.push_back(argv[i]);
+			}
+		}
+		std::string command = args.empty() ? "" : args[0];
+		try {
+			if ((command == "pack" || command == "append") && args.size() >= 3) {
+				if (!keep_text && !tokenize) {
+					std::cout << "--drop-text needs --tokenize" << std::endl;
+					return 1;
+				}
+				return Pack(args[1], std::vector<std::string>(args.begin() + 2, args.end()), command == "append", tokenize, keep_text);
+			} else if (command == "unpack" && args.size() == 3) {
+				return Unpack(args[1], args[2]);
+			} else if (command == "list" && args.size() == 2) {
+				return List(args[1]);
+			}
+		} catch (const std::exception& e) {
+			std::cout << e.what() << std::endl;
+			return 1;
+		}
+		std::cout << "Usage: corpustool pack|append <archive> <directory or list>... [--tokenize] [--drop-text]" << std::endl
+			<< "       corpustool unpack <archive> <directory>" << std::endl
+			<< "       corpustool list <archive>" << std::endl;
+		return 1;
+	}
+}
+
+int main(int argc, char** argv) {
+	return RandoRater::main(argc, argv);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <ios>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pugixml.hpp"
+
+namespace RandoRater {
+
+	//What acquiring an item does besides acquiring its own symbol
+	struct ItemEffect {
+		std::string name;
+		int chain = -1; //additive group, whose levels are acquired in order whichever of them is found
+		int level = 0;
+		bool grub = false;
+		int essence = 0;
+	};
+
+	//Every item whose acquisition does more than acquire its own symbol: the levels of each additive group of
+	//additive.xml, and the grubs and essence sources of items.xml (by their action, with essence from their geo)
+	inline std::vector<ItemEffect> LoadItemCatalog(const std::string& additive_path, const std::string& items_path) {
+		std::vector<ItemEffect> catalog;
+		std::unordered_map<std::string, size_t> index;
+		pugi::xml_document additive;
+		if (!additive.load_file(additive_path.c_str())) {
+			throw std::ios_base::failure("Unable to parse " + additive_path);
+		}
+		int chain = 0;
+		for (auto group = additive.child("randomizer").child("additiveItemSet"); group; group = group.next_sibling("additiveItemSet"), chain++) {
+			int level = 0;
+			for (auto item = group.child("itemName"); item; item = item.next_sibling("itemName"), level++) {
+				ItemEffect effect;
+				effect.name = item.text().as_string();
+				effect.chain = chain;
+				effect.level = level;
+				index[effect.name] = catalog.size();
+				catalog.push_back(effect);
+			}
+		}
+
+		pugi::xml_document items;
+		if (!items.load_file(items_path.c_str())) {
+			throw std::ios_base::failure("Unable to parse " + items_path);
+		}
+		for (auto item = items.child("randomizer").child("item"); item; item = item.next_sibling("item")) {
+			std::string action = item.child("action").text().as_string();
+			if (action != "Grub" && action != "Essence") {
+				continue;
+			}
+			std::string name = item.attribute("name").as_string();
+			auto existing = index.find(name);
+			if (existing == index.end()) {
+				existing = index.emplace(name, catalog.size()).first;
+				catalog.push_back(ItemEffect());
+				catalog.back().name = name;
+			}
+			ItemEffect& effect = catalog[existing->second];
+			effect.grub = action == "Grub";
+			effect.essence = action == "Essence" ? item.child("geo").text().as_int() : 0;
+		}
+		return catalog;
+	}
+}
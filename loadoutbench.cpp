@@ -0,0 +1,105 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+#include "pugixml.hpp"
+#include "compiledlogic.hpp"
+#include "logiccache.hpp"
+#include "rater.hpp"
+
+//Compares the bitset and recursive evaluation modes on a directory of spoiler logs. Run from the repository root as
+//loadoutbench <log directory> [repetitions]
+namespace RandoRater {
+
+	struct BenchSeed {
+		std::string path;
+		std::unique_ptr<SpoilerLogText> text;
+		ParsedSpoilerLog parsed;
+		std::unordered_set<std::string> starting_items;
+	};
+
+	double SecondsSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	int main(int argc, char** argv) {
+		if (argc < 2) {
+			std::cout << "Usage: loadoutbench <log directory> [repetitions]" << std::endl;
+			return 1;
+		}
+		int repetitions = argc > 2 ? std::max(1, atoi(argv[2])) : 5;
+
+		CompiledLogic logic = LoadLogic(kParsedLogicPath, kCompiledLogicPath, DefaultCompileOptions(true), false);
+		std::vector<BenchSeed> seeds;
+		for (auto& entry : std::filesystem::directory_iterator(argv[1])) {
+			if (!entry.is_regular_file()) {
+				continue;
+			}
+			BenchSeed seed;
+			seed.path = entry.path().string();
+			seed.text = ReadSpoilerLog(seed.path);
+			seed.parsed = ParseSpoilerLog(seed.text->text);
+			AddDefaultItems(seed.parsed);
+			seed.starting_items.insert(seed.parsed.settings.start_location);
+			seeds.push_back(std::move(seed));
+		}
+		if (seeds.empty()) {
+			std::cout << "No spoiler logs in " << argv[1] << std::endl;
+			return 1;
+		}
+
+		//Every loadout against a state with roughly half of the symbols acquired
+		std::vector<uint64_t> available(logic.mask_words, 0);
+		for (SymbolId symbol = 0; symbol < logic.symbols.size(); symbol += 2) {
+			SetMaskBit(available.data(), symbol);
+		}
+		std::vector<unsigned char> status(logic.location_logic.LoadoutCount());
+		int classify_rounds = 10000;
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < classify_rounds; r++) {
+			available[0] ^= r & 1;
+			ClassifyLoadouts(logic.location_logic.masks.data, logic.mask_words, 0, logic.location_logic.LoadoutCount(), available.data(),
+				logic.macro_mask.data, status.data());
+		}
+		double classify_seconds = SecondsSince(start);
+		std::cout << "ClassifyLoadouts: " << logic.location_logic.LoadoutCount() << " loadouts of " << logic.mask_words * 64 << " bits in "
+			<< classify_seconds / classify_rounds * 1e6 << " us" << std::endl;
+
+		const EvaluationMode modes[] = { EvaluationMode::kRecursive, EvaluationMode::kBitset };
+		const char* mode_names[] = { "recursive", "bitset" };
+		std::vector<std::vector<SeedRating>> results(2, std::vector<SeedRating>(seeds.size()));
+		double seconds[2] = { 0, 0 };
+		for (int r = 0; r < repetitions; r++) {
+			for (int m = 0; m < 2; m++) {
+				EvaluationOptions options;
+				options.mode = modes[m];
+				start = std::chrono::steady_clock::now();
+				for (size_t s = 0; s < seeds.size(); s++) {
+					results[m][s] = RateProgression(logic, seeds[s].parsed.item_locations, seeds[s].starting_items, options);
+				}
+				seconds[m] += SecondsSince(start);
+			}
+		}
+
+		int mismatches = 0;
+		for (size_t s = 0; s < seeds.size(); s++) {
+			if (results[0][s].raw != results[1][s].raw || results[0][s].checks_taken != results[1][s].checks_taken) {
+				std::cout << "Mismatch " << seeds[s].path << ": " << results[0][s].raw << " recursive, " << results[1][s].raw << " bitset" << std::endl;
+				mismatches++;
+			}
+		}
+		for (int m = 0; m < 2; m++) {
+			std::cout << "RateProgression (" << mode_names[m] << "): " << seconds[m] / repetitions / seeds.size() * 1e6 << " us per seed" << std::endl;
+		}
+		std::cout << "Speedup: " << seconds[0] / seconds[1] << "x over " << seeds.size() << " seeds, " << mismatches << " mismatches" << std::endl;
+		return mismatches == 0 ? 0 : 1;
+	}
+}
+
+int main(int argc, char** argv) {
+	return RandoRater::main(argc, argv);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RANDORATER_SSE2
+#endif
+
+namespace RandoRater {
+
+	//Loadouts are also stored as bitsets over symbol ids, padded to whole 256 bit vectors
+	const int kMaskVectorWords = 4;
+
+	inline int MaskWords(int symbol_count) {
+		int vectors = (symbol_count + 64 * kMaskVectorWords - 1) / (64 * kMaskVectorWords);
+		return (vectors > 0 ? vectors : 1) * kMaskVectorWords;
+	}
+
+	inline void SetMaskBit(uint64_t* mask, int bit) {
+		mask[bit / 64] |= 1ull << (bit % 64);
+	}
+
+	inline void ClearMaskBit(uint64_t* mask, int bit) {
+		mask[bit / 64] &= ~(1ull << (bit % 64));
+	}
+
+	//bits must not be 0
+	inline int CountTrailingZeros(uint64_t bits) {
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return (int) index;
+#else
+		return __builtin_ctzll(bits);
+#endif
+	}
+
+	enum LoadoutStatus : unsigned char {
+		kLoadoutSatisfied, //every symbol is acquired or ignored
+		kLoadoutBlocked, //only missing symbols that are not macros, so it fails without any evaluation
+		kLoadoutUndecided //missing a macro, which has to be evaluated
+	};
+
+	//Compares loadouts [first, last) against the available (acquired or ignored) symbols, macro_mask marks which symbols are macros
+	inline void ClassifyLoadouts(const uint64_t* masks, int mask_words, int first, int last, const uint64_t* available,
+		const uint64_t* macro_mask, unsigned char* status) {
+		for (int l = first; l < last; l++) {
+			const uint64_t* mask = masks + (size_t) l * mask_words;
+#if defined(__AVX2__)
+			__m256i missing = _mm256_setzero_si256(), missing_macros = _mm256_setzero_si256();
+			for (int w = 0; w < mask_words; w += 4) {
+				__m256i cur_missing = _mm256_andnot_si256(_mm256_loadu_si256((const __m256i*) (available + w)), _mm256_loadu_si256((const __m256i*) (mask + w)));
+				missing = _mm256_or_si256(missing, cur_missing);
+				missing_macros = _mm256_or_si256(missing_macros, _mm256_and_si256(cur_missing, _mm256_loadu_si256((const __m256i*) (macro_mask + w))));
+			}
+			bool any_missing = !_mm256_testz_si256(missing, missing), any_missing_macro = !_mm256_testz_si256(missing_macros, missing_macros);
+#elif defined(RANDORATER_SSE2)
+			__m128i missing = _mm_setzero_si128(), missing_macros = _mm_setzero_si128();
+			for (int w = 0; w < mask_words; w += 2) {
+				__m128i cur_missing = _mm_andnot_si128(_mm_loadu_si128((const __m128i*) (available + w)), _mm_loadu_si128((const __m128i*) (mask + w)));
+				missing = _mm_or_si128(missing, cur_missing);
+				missing_macros = _mm_or_si128(missing_macros, _mm_and_si128(cur_missing, _mm_loadu_si128((const __m128i*) (macro_mask + w))));
+			}
+			bool any_missing = _mm_movemask_epi8(_mm_cmpeq_epi8(missing, _mm_setzero_si128())) != 0xFFFF;
+			bool any_missing_macro = _mm_movemask_epi8(_mm_cmpeq_epi8(missing_macros, _mm_setzero_si128())) != 0xFFFF;
+#else
+			uint64_t missing = 0, missing_macros = 0;
+			for (int w = 0; w < mask_words; w++) {
+				uint64_t cur_missing = mask[w] & ~available[w];
+				missing |= cur_missing;
+				missing_macros |= cur_missing & macro_mask[w];
+			}
+			bool any_missing = missing != 0, any_missing_macro = missing_macros != 0;
+#endif
+			status[l] = !any_missing ? kLoadoutSatisfied : any_missing_macro ? kLoadoutUndecided : kLoadoutBlocked;
+		}
+	}
+}
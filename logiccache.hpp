@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <ios>
+
+#include "pugixml.hpp"
+#include "compiledlogic.hpp"
+#include "mappedfile.hpp"
+
+namespace RandoRater {
+
+	//Maps a compiled logic image written by WriteLogicCache, returns false if it is missing, malformed or was compiled
+	//from anything other than the parsed.xml and options with the given source hash
+	inline bool LoadLogicCache(const std::string& cache_path, uint64_t source_hash, CompiledLogic& logic) {
+		auto file = std::make_shared<MappedFile>();
+		if (!file->Open(cache_path)) {
+			return false;
+		}
+		CompiledLogic cached;
+		if (!ViewLogicImage(file->data, file->size, file, cached) || cached.source_hash != source_hash) {
+			return false;
+		}
+		logic = std::move(cached);
+		return true;
+	}
+
+	inline void WriteLogicCache(const std::string& cache_path, const CompiledLogic& logic) {
+		std::string temp_path = cache_path + ".tmp";
+		{
+			std::ofstream cache(temp_path, std::ios::binary | std::ios::trunc);
+			cache.write(logic.image, logic.image_size);
+			if (!cache) {
+				throw std::ios_base::failure("Unable to write " + temp_path);
+			}
+		}
+		std::remove(cache_path.c_str()); //rename does not replace existing files on Windows
+		if (std::rename(temp_path.c_str(), cache_path.c_str()) != 0) {
+			throw std::ios_base::failure("Unable to replace " + cache_path);
+		}
+	}
+
+	//Compiled logic for parsed.xml, taken from the cache when it is up to date and compiled from the XML otherwise.
+	//The cache is only (re)written when rewrite_cache is set
+	inline CompiledLogic LoadLogic(const std::string& xml_path, const std::string& cache_path, const CompileOptions& options, bool rewrite_cache) {
+		MappedFile xml(xml_path);
+		if (!xml) {
+			throw std::ios_base::failure("Unable to open " + xml_path);
+		}
+		uint64_t source_hash = LogicSourceHash(xml.data, xml.size, options);
+
+		CompiledLogic logic;
+		if (!rewrite_cache && LoadLogicCache(cache_path, source_hash, logic)) {
+			return logic;
+		}
+
+		pugi::xml_document parsed_logic_doc;
+		if (!parsed_logic_doc.load_buffer(xml.data, xml.size)) {
+			throw std::ios_base::failure("Unable to parse " + xml_path);
+		}
+		logic = CompileLogic(parsed_logic_doc, options, source_hash);
+		if (rewrite_cache) {
+			WriteLogicCache(cache_path, logic);
+		}
+		return logic;
+	}
+}
@@ -0,0 +1,320 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <cstdio>
+
+#include "pugixml.hpp"
+#include "compiledlogic.hpp"
+#include "mappedfile.hpp"
+#include "rater.hpp"
+
+//Generates the rater's logic tables. Run from the repository root as
+//logiccodegen [--embed] [--ignore-bad-difficulty]
+//logictables.hpp, the checks that keep their vanilla grubs and essence and the hand-picked names, is rewritten once the
+//tables below agree with items.xml
+//With --embed the compiled parsed.xml is also written to embeddedlogic.hpp, for builds with RANDORATER_EMBEDDED_LOGIC
+namespace RandoRater {
+
+	const char* const kLogicTablesPath = "logictables.hpp";
+	const char* const kEmbeddedLogicPath = "embeddedlogic.hpp";
+
+	//Checks that keep their vanilla grub when grubs are not randomized. The order decides the order they are added to a
+	//seed's checks in, which breaks ties between equally rated checks, so it is kept as it was written
+	const char* const kDefaultGrubLocations[] = {
+		"Grub-Greenpath_Stag",
+		"Grub-Hive_Internal",
+		"Grub-City_of_Tears_Guarded",
+		"Grub-Crossroads_Center",
+		"Grub-Collector_3",
+		"Grub-Waterways_East",
+		"Grub-King's_Station",
+		"Grub-Soul_Sanctum",
+		"Grub-Crossroads_Spike",
+		"Grub-Howling_Cliffs",
+		"Grub-Queen's_Gardens_Stag",
+		"Grub-Dark_Deepnest",
+		"Grub-Fog_Canyon",
+		"Grub-Waterways_Main",
+		"Grub-Crystal_Peak_Spike",
+		"Grub-Deepnest_Nosk",
+		"Grub-Crystal_Peak_Crushers",
+		"Grub-Crossroads_Guarded",
+		"Grub-Resting_Grounds",
+		"Grub-Waterways_Requires_Tram",
+		"Grub-Crystal_Peak_Mimic",
+		"Grub-Fungal_Spore_Shroom",
+		"Grub-Basin_Requires_Wings",
+		"Grub-Greenpath_MMC",
+		"Grub-City_of_Tears_Left",
+		"Grub-Crossroads_Acid",
+		"Grub-Basin_Requires_Dive",
+		"Grub-Hallownest_Crown",
+		"Grub-Queen's_Gardens_Marmu",
+		"Grub-Crossroads_Stag",
+		"Grub-Fungal_Bouncy",
+		"Grub-Crystal_Peak_Below_Chest",
+		"Grub-Collector_1",
+		"Grub-Greenpath_Cornifer",
+		"Grub-Watcher's_Spire",
+		"Grub-Hive_External",
+		"Grub-Deepnest_Mimic",
+		"Grub-Crystal_Heart",
+		"Grub-Kingdom's_Edge_Camp",
+		"Grub-Deepnest_Spike",
+		"Grub-Kingdom's_Edge_Oro",
+		"Grub-Collector_2",
+		"Grub-Beast's_Den",
+		"Grub-Queen's_Gardens_Top",
+		"Grub-Greenpath_Journal"
+	};
+
+	//Essence from each root and dream warrior, checked against the geo of items.xml. Kept in order for the same reason
+	const std::pair<const char*, int> kDefaultEssenceRewards[] = {
+		{ "Whispering_Root-Kingdoms_Edge", 51 },
+		{ "Whispering_Root-Ancestral_Mound", 42 },
+		{ "Whispering_Root-Hive", 20 },
+		{ "Whispering_Root-City", 28 },
+		{ "Whispering_Root-Waterways", 35 },
+		{ "Whispering_Root-Crossroads", 29 },
+		{ "Whispering_Root-Greenpath", 44 },
+		{ "Whispering_Root-Leg_Eater", 20 },
+		{ "Whispering_Root-Spirits_Glade", 34 },
+		{ "Whispering_Root-Queens_Gardens", 29 },
+		{ "Whispering_Root-Resting_Grounds", 20 },
+		{ "Whispering_Root-Mantis_Village", 18 },
+		{ "Whispering_Root-Howling_Cliffs", 46 },
+		{ "Whispering_Root-Deepnest", 45 },
+		{ "Whispering_Root-Crystal_Peak", 21 },
+		{ "Elder_Hu", 100 },
+		{ "Galien", 200 },
+		{ "Gorb", 100 },
+		{ "Markoth", 250 },
+		{ "Marmu", 150 },
+		{ "No_Eyes", 200 },
+		{ "Xero", 100 }
+	};
+
+	//In items.xml but never counted as default items by the rater
+	const char* const kNotDefaultItems[] = { "Grub-Crystallized_Mound", "Failed_Champion", "Soul_Tyrant", "Lost_Kin" };
+
+	//Charms the spoiler log lists under their own name, and the symbol each gives
+	const std::pair<const char*, const char*> kMiscCharms[] = {
+		{ "Shaman_Stone", "Salubra" },
+		{ "Quick_Slash", "Quick_Slash" },
+		{ "Fragile_Strength", "Leg_Eater" },
+		{ "Hiveblood", "Hiveblood" }
+	};
+
+	//Settings and counters that the rater does not model, they always evaluate to 0
+	const char* const kIgnoredMacros[] = {
+		"MILDSKIPS", "FIREBALLSKIPS", "SHADESKIPS", "ACIDSKIPS", "SPIKETUNNELS", "SPICYSKIPS", "DARKROOMS", "CURSED", "NOTCURSED",
+		"Focus", "GRUBCOUNT", "ESSENCECOUNT", "200ESSENCE"
+	};
+
+	const char* const kGeneratedNotice = "//Generated by logiccodegen.cpp, do not edit by hand\n";
+
+	void WriteGeneratedFile(const std::string& path, const std::string& contents) {
+		std::string temp_path = path + ".tmp";
+		{
+			std::ofstream out(temp_path, std::ios::binary);
+			out << contents;
+			if (!out) {
+				throw std::ios_base::failure("Unable to write " + temp_path);
+			}
+		}
+		std::remove(path.c_str());
+		if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+			throw std::ios_base::failure("Unable to replace " + path);
+		}
+	}
+
+	std::string Quoted(std::string_view str) {
+		std::string res = "\"";
+		for (char c : str) {
+			if (c == '"' || c == '\\') {
+				res += '\\';
+			}
+			res += c;
+		}
+		return res + '"';
+	}
+
+	//Every grub and essence source of items.xml has to be in the tables or in kNotDefaultItems, with the same essence
+	std::string CheckAgainstItems() {
+		pugi::xml_document items;
+		if (!items.load_file(kItemsPath)) {
+			throw std::ios_base::failure(std::string("Unable to parse ") + kItemsPath);
+		}
+		std::set<std::string> grubs(std::begin(kDefaultGrubLocations), std::end(kDefaultGrubLocations));
+		std::map<std::string, int> essence_rewards(std::begin(kDefaultEssenceRewards), std::end(kDefaultEssenceRewards));
+		std::set<std::string> excluded(std::begin(kNotDefaultItems), std::end(kNotDefaultItems));
+		std::string errors;
+		for (auto item = items.child("randomizer").first_child(); item; item = item.next_sibling()) {
+			std::string name = item.attribute("name").as_string();
+			std::string pool = item.child("pool").text().as_string();
+			if (excluded.count(name)) {
+				continue;
+			} else if (pool == "Grub" && !grubs.erase(name)) {
+				errors += "Grub " + name + " is missing\n";
+			} else if (pool == "Root" || pool == "Essence_Boss") {
+				auto essence = essence_rewards.find(name);
+				if (essence == essence_rewards.end()) {
+					errors += "Essence from " + name + " is missing\n";
+				} else {
+					if (essence->second != item.child("geo").text().as_int()) {
+						errors += "Essence from " + name + " is " + std::to_string(essence->second) + " instead of " + item.child("geo").text().as_string() + "\n";
+					}
+					essence_rewards.erase(essence);
+				}
+			}
+		}
+		for (auto& grub : grubs) {
+			errors += "Grub " + grub + " is not in " + kItemsPath + "\n";
+		}
+		for (auto& essence : essence_rewards) {
+			errors += "Essence from " + essence.first + " is not in " + kItemsPath + "\n";
+		}
+		return errors;
+	}
+
+	std::string GenerateLogicTables() {
+		std::ostringstream out;
+		out << "#pragma once\n\n" << kGeneratedNotice << "\n#include <string>\n#include <string_view>\n#include <unordered_map>\n#include <unordered_set>\n\n"
+			<< "namespace RandoRater {\n\n";
+		out << "\tinline std::unordered_set<std::string_view> default_grub_locations {\n";
+		for (size_t g = 0; g < std::size(kDefaultGrubLocations); g++) {
+			out << "\t\t" << Quoted(kDefaultGrubLocations[g]) << (g + 1 < std::size(kDefaultGrubLocations) ? ",\n" : "\n");
+		}
+		out << "\t};\n\tinline std::unordered_map<std::string_view, int> default_essence_rewards {\n";
+		for (size_t e = 0; e < std::size(kDefaultEssenceRewards); e++) {
+			out << "\t\tstd::make_pair(" << Quoted(kDefaultEssenceRewards[e].first) << ", " << kDefaultEssenceRewards[e].second << ")"
+				<< (e + 1 < std::size(kDefaultEssenceRewards) ? ",\n" : "\n");
+		}
+		out << "\t};\n\tinline std::unordered_map<std::string_view, std::string> misc_charms {\n";
+		for (size_t c = 0; c < std::size(kMiscCharms); c++) {
+			out << "\t\tstd::make_pair(" << Quoted(kMiscCharms[c].first) << ", " << Quoted(kMiscCharms[c].second) << ")"
+				<< (c + 1 < std::size(kMiscCharms) ? ",\n" : "\n");
+		}
+		out << "\t};\n\tinline std::unordered_set<std::string> ignored_macros {\n";
+		for (size_t m = 0; m < std::size(kIgnoredMacros); m++) {
+			out << "\t\t" << Quoted(kIgnoredMacros[m]) << (m + 1 < std::size(kIgnoredMacros) ? ",\n" : "\n");
+		}
+		out << "\t};\n}\n";
+		return out.str();
+	}
+
+	//Symbol names as identifiers, made unique by appending the id where two names only differ in punctuation
+	std::vector<std::string> EnumeratorNames(const SymbolTable& table) {
+		std::vector<std::string> res;
+		std::set<std::string> used;
+		for (SymbolId id = 0; id < table.size(); id++) {
+			std::string name;
+			for (char c : table.Name(id)) {
+				name += isalnum((unsigned char) c) ? c : '_';
+			}
+			if (name.empty() || isdigit((unsigned char) name[0])) {
+				name = "n" + name;
+			}
+			if (!used.insert(name).second) {
+				name += "_" + std::to_string(id);
+				used.insert(name);
+			}
+			res.push_back(name);
+		}
+		return res;
+	}
+
+	void WriteEnum(std::ostream& out, const char* name, const SymbolTable& table) {
+		std::vector<std::string> enumerators = EnumeratorNames(table);
+		out << "\tnamespace " << name << " {\n\t\tenum : SymbolId {\n";
+		for (SymbolId id = 0; id < table.size(); id++) {
+			out << "\t\t\t" << enumerators[id] << " = " << id << (id + 1 < table.size() ? ",\n" : "\n");
+		}
+		out << "\t\t};\n\t}\n\n";
+	}
+
+	//The image as native endian words, so it can only be used on machines with the same endianness as the generator's
+	std::string GenerateEmbeddedLogic(bool ignore_bad_difficulty) {
+		MappedFile xml(kParsedLogicPath);
+		if (!xml) {
+			throw std::ios_base::failure(std::string("Unable to open ") + kParsedLogicPath);
+		}
+		CompileOptions options;
+		options.ignored_macros.assign(std::begin(kIgnoredMacros), std::end(kIgnoredMacros));
+		options.additive_path = kAdditiveItemsPath;
+		options.items_path = kItemsPath;
+		options.ignore_bad_difficulty = ignore_bad_difficulty;
+		pugi::xml_document parsed_logic_doc;
+		if (!parsed_logic_doc.load_buffer(xml.data, xml.size)) {
+			throw std::ios_base::failure(std::string("Unable to parse ") + kParsedLogicPath);
+		}
+		CompiledLogic logic = CompileLogic(parsed_logic_doc, options, LogicSourceHash(xml.data, xml.size, options));
+
+		std::ostringstream out;
+		out << "#pragma once\n\n" << kGeneratedNotice << "//from " << kParsedLogicPath << (ignore_bad_difficulty ? " with --ignore-bad-difficulty" : "")
+			<< "\n\n#include <cstddef>\n#include <cstdint>\n\n#include \"compiledlogic.hpp\"\n\nnamespace RandoRater {\n\n";
+		out << "\tconstexpr bool kEmbeddedIgnoreBadDifficulty = " << (ignore_bad_difficulty ? "true" : "false") << ";\n"
+			<< "\tconstexpr uint64_t kEmbeddedLogicSourceHash = " << logic.source_hash << "ull;\n"
+			<< "\tconstexpr int kEmbeddedSymbolCount = " << logic.symbols.size() << ";\n"
+			<< "\tconstexpr int kEmbeddedMacroCount = " << logic.macro_count << ";\n"
+			<< "\tconstexpr int kEmbeddedLocationCount = " << logic.locations.size() << ";\n"
+			<< "\tconstexpr int kEmbeddedMacroLoadoutCount = " << logic.macro_logic.LoadoutCount() << ";\n"
+			<< "\tconstexpr int kEmbeddedLocationLoadoutCount = " << logic.location_logic.LoadoutCount() << ";\n"
+			<< "\tconstexpr int kEmbeddedMaskWords = " << logic.mask_words << ";\n"
+			<< "\tconstexpr size_t kEmbeddedLogicImageSize = " << logic.image_size << ";\n\n";
+		WriteEnum(out, "EmbeddedSymbols", logic.symbols);
+		WriteEnum(out, "EmbeddedLocations", logic.locations);
+
+		size_t words = (logic.image_size + 7) / 8;
+		std::vector<uint64_t> image(words, 0);
+		memcpy(image.data(), logic.image, logic.image_size);
+		out << "\talignas(8) inline constexpr uint64_t kEmbeddedLogicImage[" << words << "] = {\n";
+		char word[32];
+		for (size_t w = 0; w < words; w++) {
+			snprintf(word, sizeof(word), "0x%016llxull", (unsigned long long) image[w]);
+			out << (w % 4 == 0 ? "\t\t" : " ") << word << (w + 1 < words ? "," : "") << (w % 4 == 3 || w + 1 == words ? "\n" : "");
+		}
+		out << "\t};\n}\n";
+		return out.str();
+	}
+
+	int main(int argc, char** argv) {
+		bool embed = false, ignore_bad_difficulty = false;
+		for (int i = 1; i < argc; i++) {
+			if (strcmp(argv[i], "--embed") == 0) {
+				embed = true;
+			} else if (strcmp(argv[i], "--ignore-bad-difficulty") == 0) {
+				ignore_bad_difficulty = true;
+			}
+		}
+
+		try {
+			std::string errors = CheckAgainstItems();
+			if (!errors.empty()) {
+				std::cout << errors << "Update the tables in logiccodegen.cpp to match " << kItemsPath << std::endl;
+				return 1;
+			}
+			WriteGeneratedFile(kLogicTablesPath, GenerateLogicTables());
+			std::cout << "Wrote " << kLogicTablesPath << std::endl;
+			if (embed) {
+				WriteGeneratedFile(kEmbeddedLogicPath, GenerateEmbeddedLogic(ignore_bad_difficulty));
+				std::cout << "Wrote " << kEmbeddedLogicPath << std::endl;
+			}
+		} catch (const std::exception& e) {
+			std::cout << e.what() << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char** argv) {
+	return RandoRater::main(argc, argv);
+}
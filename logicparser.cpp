@@ -4,22 +4,33 @@
 #include <string_view>
 #include <unordered_set>
 #include <algorithm>
+#include <map>
+#include <deque>
+#include <chrono>
+#include <cctype>
+#include <tuple>
+#include <unordered_map>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <stdexcept>
+#include <cstdio>
+#include <iterator>
 
 #include "pugixml.hpp"
+#include "compiledlogic.hpp"
+#include "threadpool.hpp"
 
 using namespace std;
 
 const string_view kPlusStringView = string_view("+"), kPipeStringView = string_view("|");
 
 struct LogicNode {
-	LogicNode* left;
-	LogicNode* right;
-	const string_view val;
-	LogicNode(string_view v) : left(nullptr), right(nullptr), val(v) {}
-	LogicNode(LogicNode* l, LogicNode* r, string_view v) : left(l), right(r), val(v) {}
-	~LogicNode() { delete left; delete right; }
-
-	void print() {
+	const LogicNode* left = nullptr;
+	const LogicNode* right = nullptr;
+	string_view val; //the operator, or the name of a literal
+
+	void print() const {
 		if (left == nullptr && right == nullptr) {
 			cout << string(val) << ";" << endl;
 			return;
@@ -30,175 +41,621 @@ struct LogicNode {
 	}
 };
 
-LogicNode* MakeLogicTree(string_view logic) {
-	vector<string_view> tokens;
-	vector<char> operators;
-	int expr_start = 0, parenthesis_balance = 0;
-	for (int i = 0; i < logic.length(); i++) {
-		if ((logic.at(i) == '+' || logic.at(i) == '|') && parenthesis_balance == 0) {
-			tokens.push_back(logic.substr(expr_start, i - expr_start - 1));
-			operators.push_back(logic.at(i));
-			expr_start = i + 2;
-			i++;
-			continue;
-		} else if (logic.at(i) == '(') {
-			parenthesis_balance++;
-		} else if (logic.at(i) == ')') {
-			parenthesis_balance--;
+//Bump allocator for logic trees, every node is freed at once by Clear
+class LogicArena {
+public:
+	LogicNode* New(const LogicNode* left, const LogicNode* right, string_view val) {
+		if (used == kBlockSize) {
+			if (++block == blocks.size()) {
+				blocks.push_back(make_unique<LogicNode[]>(kBlockSize));
+			}
+			used = 0;
 		}
+		LogicNode* node = &blocks[block][used++];
+		node->left = left;
+		node->right = right;
+		node->val = val;
+		return node;
+	}
+
+	void Clear() {
+		block = (size_t) -1;
+		used = kBlockSize;
 	}
-	tokens.push_back(logic.substr(expr_start, logic.length() - expr_start));
-	if (operators.empty()) {
-		if (tokens[0].at(0) == '(') { //remove unnecessary parenthesis, e.g "(((ITEM)))"
-			return MakeLogicTree(tokens[0].substr(1, tokens[0].length() - 2));
+
+private:
+	static const size_t kBlockSize = 256;
+	vector<unique_ptr<LogicNode[]>> blocks;
+	size_t block = (size_t) -1, used = kBlockSize;
+};
+
+enum class LogicTokenType {
+	kName, kAnd, kOr, kOpen, kClose, kEnd
+};
+
+struct LogicToken {
+	LogicTokenType type;
+	string_view text;
+};
+
+//Names are anything between whitespace and the operator/parenthesis characters
+void TokenizeLogic(string_view logic, vector<LogicToken>& tokens) {
+	tokens.clear();
+	size_t i = 0;
+	while (i < logic.length()) {
+		char c = logic[i];
+		if (isspace((unsigned char) c)) {
+			i++;
+		} else if (c == '+' || c == '|' || c == '(' || c == ')') {
+			LogicTokenType type = c == '+' ? LogicTokenType::kAnd : c == '|' ? LogicTokenType::kOr : c == '(' ? LogicTokenType::kOpen : LogicTokenType::kClose;
+			tokens.push_back({ type, logic.substr(i, 1) });
+			i++;
 		} else {
-			return new LogicNode(tokens[0]);
+			size_t start = i;
+			while (i < logic.length() && !isspace((unsigned char) logic[i]) && strchr("+|()", logic[i]) == nullptr) {
+				i++;
+			}
+			tokens.push_back({ LogicTokenType::kName, logic.substr(start, i - start) });
 		}
 	}
-	vector<LogicNode*> tokens_as_trees;
-	for (auto& token : tokens) {
-		if (token.at(0) == '(') {
-			tokens_as_trees.push_back(MakeLogicTree(token.substr(1, token.length() - 2)));
-		} else {
-			tokens_as_trees.push_back(MakeLogicTree(token));
+	tokens.push_back({ LogicTokenType::kEnd, logic.substr(logic.length()) });
+}
+
+//Precedence climbing over the tokens, "+" binds tighter than "|" and both group to the right
+class LogicParser {
+public:
+	LogicParser(string_view logic, const vector<LogicToken>& tokens, LogicArena& arena) : logic(logic), tokens(tokens), arena(arena) {}
+
+	const LogicNode* Parse() {
+		const LogicNode* tree = ParseExpression(0);
+		if (tokens[pos].type != LogicTokenType::kEnd) {
+			Fail("unexpected \"" + string(tokens[pos].text) + "\"");
 		}
+		return tree;
+	}
+
+private:
+	string_view logic;
+	const vector<LogicToken>& tokens;
+	LogicArena& arena;
+	size_t pos = 0;
+
+	[[noreturn]] void Fail(const string& message) {
+		throw logic_error("Malformed logic, " + message + " in \"" + string(logic) + "\"");
 	}
 
-	for (int i = operators.size() - 1; i >= 0; i--) {
-		if (operators[i] == '+') {
-			LogicNode* new_parent = new LogicNode(tokens_as_trees[i], tokens_as_trees[i + 1], kPlusStringView);
-			tokens_as_trees.erase(tokens_as_trees.begin() + i + 1);
-			tokens_as_trees[i] = new_parent;
-			operators.erase(operators.begin() + i);
+	static int Precedence(LogicTokenType type) {
+		return type == LogicTokenType::kAnd ? 2 : type == LogicTokenType::kOr ? 1 : -1;
+	}
+
+	const LogicNode* ParsePrimary() {
+		const LogicToken& token = tokens[pos++];
+		if (token.type == LogicTokenType::kName) {
+			return arena.New(nullptr, nullptr, token.text);
+		} else if (token.type == LogicTokenType::kOpen) {
+			const LogicNode* inner = ParseExpression(0);
+			if (tokens[pos++].type != LogicTokenType::kClose) {
+				Fail("missing \")\"");
+			}
+			return inner;
 		}
+		Fail(token.type == LogicTokenType::kEnd ? string("missing operand") : "unexpected \"" + string(token.text) + "\"");
 	}
 
-	for (int i = operators.size() - 1; i >= 0; i--) {
-		LogicNode* new_parent = new LogicNode(tokens_as_trees[i], tokens_as_trees[i + 1], kPipeStringView);
-		tokens_as_trees[i] = new_parent;
-		tokens_as_trees.pop_back();
+	const LogicNode* ParseExpression(int min_precedence) {
+		const LogicNode* left = ParsePrimary();
+		int precedence;
+		while ((precedence = Precedence(tokens[pos].type)) >= min_precedence) {
+			string_view op = tokens[pos++].type == LogicTokenType::kAnd ? kPlusStringView : kPipeStringView;
+			const LogicNode* right = ParseExpression(precedence);
+			left = arena.New(left, right, op);
+		}
+		return left;
 	}
+};
 
-	return *&tokens_as_trees[0];
+const LogicNode* MakeLogicTree(string_view logic, LogicArena& arena, vector<LogicToken>& tokens) {
+	TokenizeLogic(logic, tokens);
+	return LogicParser(logic, tokens, arena).Parse();
 }
 
-unique_ptr<vector<string>> SplitLogicStatement(LogicNode* logic_tree) {
-	if (logic_tree->left == nullptr && logic_tree->right == nullptr) {
-		auto res = make_unique<vector<string>>();
-		res->push_back(string(logic_tree->val));
-		return res;
-	} else if (logic_tree->val.at(0) == '+') {
-		auto res = make_unique<vector<string>>();
-		auto left_statements = *SplitLogicStatement(logic_tree->left), right_statements = *SplitLogicStatement(logic_tree->right);
-		for (auto& left_statement : left_statements) {
-			for (auto& right_statement : right_statements) {
-				res->push_back(left_statement + " + " + right_statement);
+//Every conjunction is kept as a set of interned literal ids, in the order the literals first appear (which is the order
+//the rater evaluates them in) and sorted for subset tests
+struct Conjunction {
+	vector<int> literals;
+	vector<int> sorted;
+	int difficulty = 0;
+};
+
+typedef vector<Conjunction> Dnf;
+
+//a absorbs b when b needs everything a does and is no easier, so b never gives a better rating than a. Loadouts with
+//an unassigned difficulty (-1) are never compared
+bool Absorbs(const Conjunction& a, const Conjunction& b) {
+	return a.difficulty >= 0 && a.difficulty <= b.difficulty && a.sorted.size() <= b.sorted.size() && includes(b.sorted.begin(), b.sorted.end(), a.sorted.begin(), a.sorted.end());
+}
+
+//Expands logic trees into minimal DNF. Structurally equal subtrees are hash-consed into the same node, so shared
+//subexpressions (within and across entries) are only expanded once
+struct DnfBuilder {
+	struct Node {
+		char op; //0 for literals, which keep their literal id in left
+		int left, right;
+	};
+
+	size_t max_loadouts = 4096; //expanding past this many loadouts for one subexpression is an error
+	bool absorb = true; //only drop duplicate loadouts if not set
+	deque<string> literal_names;
+	unordered_map<string_view, int> literal_ids; //views into literal_names
+	vector<Node> nodes;
+	map<tuple<char, int, int>, int> node_ids;
+	vector<unique_ptr<Dnf>> expanded;
+	vector<double> unminimized_counts;
+	double loadouts_before = 0; //what the plain cartesian expansion would have written
+	size_t loadouts_after = 0;
+
+	int InternNode(char op, int left, int right) {
+		auto inserted = node_ids.emplace(make_tuple(op, left, right), (int) nodes.size());
+		if (inserted.second) {
+			nodes.push_back({ op, left, right });
+			expanded.emplace_back();
+			unminimized_counts.push_back(op == 0 ? 1 : op == '+' ? unminimized_counts[left] * unminimized_counts[right] : unminimized_counts[left] + unminimized_counts[right]);
+		}
+		return inserted.first->second;
+	}
+
+	int InternLiteral(string_view name) {
+		auto found = literal_ids.find(name);
+		if (found == literal_ids.end()) {
+			literal_names.emplace_back(name);
+			found = literal_ids.emplace(literal_names.back(), (int) literal_names.size() - 1).first;
+		}
+		return found->second;
+	}
+
+	int HashCons(const LogicNode* logic_tree) {
+		if (logic_tree->left == nullptr && logic_tree->right == nullptr) {
+			return InternNode(0, InternLiteral(logic_tree->val), 0);
+		} else if (logic_tree->val.at(0) == '+' || logic_tree->val.at(0) == '|') {
+			int left = HashCons(logic_tree->left), right = HashCons(logic_tree->right);
+			return InternNode(logic_tree->val.at(0), left, right);
+		} else {
+			throw logic_error("Improperly constructed expression tree. Likely cause is malformed logic");
+		}
+	}
+
+	//Adds c unless an existing conjunction absorbs it, dropping the existing conjunctions c absorbs
+	static void AddConjunction(Dnf& dnf, Conjunction&& c, bool absorb = true) {
+		for (auto& existing : dnf) {
+			if (absorb ? Absorbs(existing, c) : existing.sorted == c.sorted) {
+				return;
 			}
 		}
+		if (absorb) {
+			dnf.erase(remove_if(dnf.begin(), dnf.end(), [&](const Conjunction& existing) { return Absorbs(c, existing); }), dnf.end());
+		}
+		dnf.push_back(move(c));
+	}
+
+	const Dnf& Expand(int node_id) {
+		if (expanded[node_id]) {
+			return *expanded[node_id];
+		}
+		Node node = nodes[node_id];
+		auto res = make_unique<Dnf>();
+		if (node.op == 0) {
+			res->push_back({ { node.left }, { node.left } });
+		} else if (node.op == '|') {
+			*res = Expand(node.left);
+			for (auto& right : Expand(node.right)) {
+				AddConjunction(*res, Conjunction(right), absorb);
+			}
+		} else {
+			const Dnf& left_dnf = Expand(node.left);
+			const Dnf& right_dnf = Expand(node.right);
+			for (auto& left : left_dnf) {
+				for (auto& right : right_dnf) {
+					Conjunction c = left;
+					for (int literal : right.literals) {
+						if (!binary_search(left.sorted.begin(), left.sorted.end(), literal)) {
+							c.literals.push_back(literal);
+						}
+					}
+					c.sorted = c.literals;
+					sort(c.sorted.begin(), c.sorted.end());
+					c.difficulty = max(left.difficulty, right.difficulty);
+					AddConjunction(*res, move(c), absorb);
+				}
+				if (res->size() > max_loadouts) {
+					throw length_error("Logic expands to more than " + to_string(max_loadouts) + " loadouts");
+				}
+			}
+		}
+		expanded[node_id] = move(res);
+		return *expanded[node_id];
+	}
+
+	const Dnf& SplitLogicStatement(string_view logic) {
+		static const Dnf always = { Conjunction() };
+		if (logic.find_first_not_of(" \t\r\n") == string_view::npos) {
+			loadouts_before++;
+			loadouts_after++;
+			return always;
+		}
+		arena.Clear();
+		int root = HashCons(MakeLogicTree(logic, arena, tokens));
+		const Dnf& res = Expand(root);
+		loadouts_before += unminimized_counts[root];
+		loadouts_after += res.size();
 		return res;
-	} else if (logic_tree->val.at(0) == '|') {
-		auto res = make_unique<vector<string>>(*SplitLogicStatement(logic_tree->left));
-		auto right = *SplitLogicStatement(logic_tree->right);
-		res->insert(res->end(), right.begin(), right.end());
-		return res;
-	} else {
-		throw logic_error("Improperly constructed expression tree. Likely cause is malformed logic");
 	}
-}
-unique_ptr<vector<string>> SplitLogicStatement(const string& logic) {
-	if (logic.empty()) {
-		return make_unique<vector<string>>(vector<string>{""});
-	}
-	LogicNode* logic_tree = MakeLogicTree(string_view(logic));
-	auto res = SplitLogicStatement(logic_tree);
-	delete logic_tree;
-	//res->erase(remove_if(res->begin(), res->end(), [](string& s) { return s.length() == 0; }), res->end());
-	return res;
-}
 
-void AppendParsedLogic(const string& item_name, const string& logic, const string& xml_node_name, pugi::xml_node& parent) {
+private:
+	LogicArena arena;
+	vector<LogicToken> tokens;
+};
+
+void AppendParsedLogic(const string& item_name, const string& logic, const string& xml_node_name, pugi::xml_node& parent, DnfBuilder& dnf_builder) {
 	pugi::xml_node output = parent.append_child(xml_node_name.c_str());
 	output.append_attribute("name").set_value(item_name.c_str());
-	auto loadouts = *SplitLogicStatement(logic);
-	for (auto& loadout : loadouts) {
+	const Dnf* loadouts;
+	try {
+		loadouts = &dnf_builder.SplitLogicStatement(logic);
+	} catch (const exception& e) {
+		throw logic_error(item_name + ": " + e.what());
+	}
+	string loadout;
+	for (auto& conjunction : *loadouts) {
+		loadout.clear();
+		for (int literal : conjunction.literals) {
+			if (!loadout.empty()) {
+				loadout += " + ";
+			}
+			loadout += dnf_builder.literal_names[literal];
+		}
 		pugi::xml_node loadout_container = output.append_child("loadout");
 		loadout_container.append_attribute("difficulty").set_value(0);
 		loadout_container.text().set(loadout.c_str());
 	}
 }
 
-auto CreateParsedLogic() {
+struct LogicEntry {
+	string name;
+	string logic;
+	bool is_location; //a macro otherwise
+};
+
+//Locations or macros from one of the randomizer's logic files, the macros after CANSTAG-R are only used by room rando
+vector<LogicEntry> ReadLogicFile(const string& stem, bool is_location) {
 	pugi::xml_document logic_xml;
-	auto parsed_logic_doc = make_unique<pugi::xml_document>();
+	vector<LogicEntry> entries;
+	if (!logic_xml.load_file(("XML/" + stem + ".xml").c_str())) {
+		if (stem == "waypoints") {
+			return entries;
+		}
+		throw ios_base::failure("Unable to read file " + stem + ".xml");
+	}
+	bool is_macro_file = stem == "macros";
+	for (pugi::xml_node item = logic_xml.child("randomizer").first_child(); item; item = item.next_sibling()) {
+		string name = item.attribute("name").as_string();
+		if (is_macro_file && name == "CANSTAG-R") {
+			break;
+		} else if (name.empty()) { //waypoints.xml has an <itemLogic> outside of any <item>
+			continue;
+		}
+		entries.push_back({ name, is_macro_file ? item.text().as_string() : item.child("itemLogic").text().as_string(), is_location });
+	}
+	return entries;
+}
+
+//Every location and macro in the order they are written to parsed.xml, the files are read in parallel
+vector<LogicEntry> ReadLogicSources() {
+	const pair<const char*, bool> files[] = { { "items", true }, { "rocks", true }, { "shops", true }, { "soul_lore", true }, { "waypoints", false }, { "macros", false } };
+	const int file_count = sizeof(files) / sizeof(files[0]);
+	vector<vector<LogicEntry>> file_entries(file_count);
+	RandoRater::ParallelFor(file_count, RandoRater::DefaultWorkerCount(), [&](int, int index) {
+		file_entries[index] = ReadLogicFile(files[index].first, files[index].second);
+	});
+
+	vector<LogicEntry> entries;
+	for (auto& file : file_entries) {
+		move(file.begin(), file.end(), back_inserter(entries));
+	}
 
+	entries.push_back({ "Radiance", "DREAMER3 + (CLAW | WINGS) + (SHADOWDASH | QUAKE)", true });
+
+	entries.push_back({ "Nailsmith", "Left_City + (MILDSKIPS | DASH | WINGS | CLAW)", false });
+
+	entries.push_back({ "NAIL1", "Nailsmith", false });
+	entries.push_back({ "NAIL2", "Nailsmith + (Pale_Ore-Grubs | Pale_Ore-Seer | Pale_Ore-Basin | Pale_Ore-Crystal_Peak | Pale_Ore-Nosk | Pale_Ore-Colosseum)", false });
+	entries.push_back({ "NAIL3", "Nailsmith + ((Pale_Ore-Grubs + Pale_Ore-Seer + Pale_Ore-Basin) | (Pale_Ore-Grubs + Pale_Ore-Seer + Pale_Ore-Crystal_Peak) | (Pale_Ore-Grubs + Pale_Ore-Seer + Pale_Ore-Nosk) | (Pale_Ore-Grubs + Pale_Ore-Seer + Pale_Ore-Colosseum) | (Pale_Ore-Grubs + Pale_Ore-Basin + Pale_Ore-Crystal_Peak) | (Pale_Ore-Grubs + Pale_Ore-Basin + Pale_Ore-Nosk) | (Pale_Ore-Grubs + Pale_Ore-Basin + Pale_Ore-Colosseum) | (Pale_Ore-Grubs + Pale_Ore-Crystal_Peak + Pale_Ore-Nosk) | (Pale_Ore-Grubs + Pale_Ore-Crystal_Peak + Pale_Ore-Colosseum) | (Pale_Ore-Grubs + Pale_Ore-Nosk + Pale_Ore-Colosseum) | (Pale_Ore-Seer + Pale_Ore-Basin + Pale_Ore-Crystal_Peak) | (Pale_Ore-Seer + Pale_Ore-Basin + Pale_Ore-Nosk) | (Pale_Ore-Seer + Pale_Ore-Basin + Pale_Ore-Colosseum) | (Pale_Ore-Seer + Pale_Ore-Crystal_Peak + Pale_Ore-Nosk) | (Pale_Ore-Seer + Pale_Ore-Crystal_Peak + Pale_Ore-Colosseum) | (Pale_Ore-Seer + Pale_Ore-Nosk + Pale_Ore-Colosseum) | (Pale_Ore-Basin + Pale_Ore-Crystal_Peak + Pale_Ore-Nosk) | (Pale_Ore-Basin + Pale_Ore-Crystal_Peak + Pale_Ore-Colosseum) | (Pale_Ore-Basin + Pale_Ore-Nosk + Pale_Ore-Colosseum) | (Pale_Ore-Crystal_Peak + Pale_Ore-Nosk + Pale_Ore-Colosseum))", false });
+	entries.push_back({ "NAIL4", "Nailsmith + (Pale_Ore-Grubs + Pale_Ore-Seer + Pale_Ore-Basin + Pale_Ore-Crystal_Peak + Pale_Ore-Nosk + Pale_Ore-Colosseum)", false });
+
+	entries.push_back({ "DASH", "Mothwing_Cloak", false });
+	entries.push_back({ "CLAW", "Mantis_Claw", false });
+	entries.push_back({ "DREAMNAIL", "Dream_Nail", false });
+	entries.push_back({ "SUPERDASH", "Crystal_Heart", false });
+	entries.push_back({ "ACID", "Isma's_Tear", false });
+	entries.push_back({ "WINGS", "Monarch_Wings", false });
+	entries.push_back({ "FIREBALL", "Vengeful_Spirit", false });
+	entries.push_back({ "QUAKE", "Desolate_Dive", false });
+	entries.push_back({ "SCREAM", "Howling_Wraiths", false });
+
+	return entries;
+}
+
+unique_ptr<pugi::xml_document> CreateParsedLogic(const vector<LogicEntry>& entries, DnfBuilder& dnf_builder) {
+	auto parsed_logic_doc = make_unique<pugi::xml_document>();
 	pugi::xml_node locs = parsed_logic_doc->append_child("locations"), macros = parsed_logic_doc->append_child("macros");
+	for (auto& entry : entries) {
+		AppendParsedLogic(entry.name, entry.logic, entry.is_location ? "location" : "macro", entry.is_location ? locs : macros, dnf_builder);
+	}
+	return parsed_logic_doc;
+}
 
-	string xml_files[] = { "items", "rocks", "shops", "soul_lore" };
-	for (string stem : xml_files) {
-		if (logic_xml.load_file(("XML/" + stem + ".xml").c_str())) {
-			for (pugi::xml_node item = logic_xml.child("randomizer").first_child(); item; item = item.next_sibling()) {
-				AppendParsedLogic(
-					item.attribute("name").as_string(),
-					item.child("itemLogic").text().as_string(),
-					"location",
-					locs
-				);
+//Times parsing alone and the whole regeneration (everything but reading the source files) over all logic entries
+void BenchmarkParsedLogic(const vector<LogicEntry>& entries, int repetitions, size_t max_loadouts) {
+	LogicArena arena;
+	vector<LogicToken> tokens;
+	size_t token_count = 0;
+	auto start = chrono::steady_clock::now();
+	for (int r = 0; r < repetitions; r++) {
+		for (auto& entry : entries) {
+			arena.Clear();
+			if (entry.logic.find_first_not_of(" \t\r\n") != string::npos) {
+				MakeLogicTree(entry.logic, arena, tokens);
+				token_count += tokens.size();
 			}
-		} else {
-			throw ios_base::failure("Unable to read file " + stem + ".xml");
 		}
 	}
+	double parse_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-	if (logic_xml.load_file("XML/waypoints.xml")) {
-		for (pugi::xml_node waypoint = logic_xml.child("randomizer").first_child(); waypoint; waypoint = waypoint.next_sibling()) {
-			AppendParsedLogic(
-				waypoint.attribute("name").as_string(),
-				waypoint.child("itemLogic").text().as_string(),
-				"macro",
-				macros
-			);
-		}
+	size_t loadouts = 0;
+	start = chrono::steady_clock::now();
+	for (int r = 0; r < repetitions; r++) {
+		DnfBuilder dnf_builder;
+		dnf_builder.max_loadouts = max_loadouts;
+		CreateParsedLogic(entries, dnf_builder);
+		loadouts = dnf_builder.loadouts_after;
 	}
+	double regenerate_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << entries.size() << " entries, " << token_count / repetitions << " tokens, " << loadouts << " loadouts" << endl;
+	cout << "Parse: " << parse_seconds / repetitions * 1000 << " ms" << endl;
+	cout << "Regenerate: " << regenerate_seconds / repetitions * 1000 << " ms" << endl;
+}
 
-	if (logic_xml.load_file("XML/macros.xml")) {
-		for (pugi::xml_node macro = logic_xml.child("randomizer").first_child(); macro && string(macro.attribute("name").as_string()) != "CANSTAG-R"; macro = macro.next_sibling()) {
-			AppendParsedLogic(
-				macro.attribute("name").as_string(),
-				macro.text().as_string(),
-				"macro",
-				macros
-			);
+uint64_t EntrySourceHash(const LogicEntry& entry) {
+	return RandoRater::HashBytes(entry.logic.data(), entry.logic.length());
+}
+
+string HexHash(uint64_t hash) {
+	char hex[17];
+	snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) hash);
+	return hex;
+}
+
+struct ParsedLoadout {
+	string text;
+	int difficulty;
+};
+
+struct ParsedEntry {
+	string source_hash; //of the logic the loadouts were expanded from, empty if not known
+	vector<ParsedLoadout> loadouts;
+};
+
+typedef map<pair<bool, string>, ParsedEntry> ParsedEntries; //keyed by (is location, name)
+
+ParsedEntries ReadParsedLogic(const string& path) {
+	ParsedEntries entries;
+	pugi::xml_document parsed_logic_doc;
+	if (!parsed_logic_doc.load_file(path.c_str())) {
+		return entries;
+	}
+	const pair<const char*, const char*> sections[] = { { "locations", "location" }, { "macros", "macro" } };
+	for (auto& section : sections) {
+		for (pugi::xml_node node = parsed_logic_doc.child(section.first).child(section.second); node; node = node.next_sibling(section.second)) {
+			ParsedEntry& entry = entries[{ section.first == sections[0].first, node.attribute("name").as_string() }];
+			entry.source_hash = node.attribute("source").as_string();
+			for (pugi::xml_node loadout = node.child("loadout"); loadout; loadout = loadout.next_sibling("loadout")) {
+				entry.loadouts.push_back({ loadout.text().as_string(), loadout.attribute("difficulty").as_int() });
+			}
 		}
-	} else {
-		throw ios_base::failure("Unable to read macros.xml");
 	}
+	return entries;
+}
 
-	AppendParsedLogic("Radiance", "DREAMER3 + (CLAW | WINGS) + (SHADOWDASH | QUAKE)", "location", locs);
+struct RegenerateCounts {
+	int entries_expanded = 0, loadouts_kept = 0, loadouts_new = 0, loadouts_dropped = 0;
+};
 
-	AppendParsedLogic("Nailsmith", "Left_City + (MILDSKIPS | DASH | WINGS | CLAW)", "macro", macros);
+//A loadout as written in parsed.xml, with its items interned by dnf_builder
+Conjunction ReadLoadout(const ParsedLoadout& loadout, DnfBuilder& dnf_builder, vector<LogicToken>& tokens) {
+	Conjunction res;
+	TokenizeLogic(loadout.text, tokens);
+	for (auto& token : tokens) {
+		int literal = token.type == LogicTokenType::kName ? dnf_builder.InternLiteral(token.text) : -1;
+		if (literal >= 0 && find(res.literals.begin(), res.literals.end(), literal) == res.literals.end()) {
+			res.literals.push_back(literal);
+		}
+	}
+	res.sorted = res.literals;
+	sort(res.sorted.begin(), res.sorted.end());
+	res.difficulty = loadout.difficulty;
+	return res;
+}
 
-	AppendParsedLogic("NAIL1", "Nailsmith", "macro", macros);
-	AppendParsedLogic("NAIL2", "Nailsmith + (Pale_Ore-Grubs | Pale_Ore-Seer | Pale_Ore-Basin | Pale_Ore-Crystal_Peak | Pale_Ore-Nosk | Pale_Ore-Colosseum)", "macro", macros);
-	AppendParsedLogic("NAIL3", "Nailsmith + ((Pale_Ore-Grubs + Pale_Ore-Seer + Pale_Ore-Basin) | (Pale_Ore-Grubs + Pale_Ore-Seer + Pale_Ore-Crystal_Peak) | (Pale_Ore-Grubs + Pale_Ore-Seer + Pale_Ore-Nosk) | (Pale_Ore-Grubs + Pale_Ore-Seer + Pale_Ore-Colosseum) | (Pale_Ore-Grubs + Pale_Ore-Basin + Pale_Ore-Crystal_Peak) | (Pale_Ore-Grubs + Pale_Ore-Basin + Pale_Ore-Nosk) | (Pale_Ore-Grubs + Pale_Ore-Basin + Pale_Ore-Colosseum) | (Pale_Ore-Grubs + Pale_Ore-Crystal_Peak + Pale_Ore-Nosk) | (Pale_Ore-Grubs + Pale_Ore-Crystal_Peak + Pale_Ore-Colosseum) | (Pale_Ore-Grubs + Pale_Ore-Nosk + Pale_Ore-Colosseum) | (Pale_Ore-Seer + Pale_Ore-Basin + Pale_Ore-Crystal_Peak) | (Pale_Ore-Seer + Pale_Ore-Basin + Pale_Ore-Nosk) | (Pale_Ore-Seer + Pale_Ore-Basin + Pale_Ore-Colosseum) | (Pale_Ore-Seer + Pale_Ore-Crystal_Peak + Pale_Ore-Nosk) | (Pale_Ore-Seer + Pale_Ore-Crystal_Peak + Pale_Ore-Colosseum) | (Pale_Ore-Seer + Pale_Ore-Nosk + Pale_Ore-Colosseum) | (Pale_Ore-Basin + Pale_Ore-Crystal_Peak + Pale_Ore-Nosk) | (Pale_Ore-Basin + Pale_Ore-Crystal_Peak + Pale_Ore-Colosseum) | (Pale_Ore-Basin + Pale_Ore-Nosk + Pale_Ore-Colosseum) | (Pale_Ore-Crystal_Peak + Pale_Ore-Nosk + Pale_Ore-Colosseum))", "macro", macros);
-	AppendParsedLogic("NAIL4", "Nailsmith + (Pale_Ore-Grubs + Pale_Ore-Seer + Pale_Ore-Basin + Pale_Ore-Crystal_Peak + Pale_Ore-Nosk + Pale_Ore-Colosseum)", "macro", macros);
+//Expands entry again and merges it with its previous loadouts. A previous loadout is kept, with its text and
+//difficulty, as long as the new logic still allows it: either it is one of the expanded loadouts or it was added by
+//hand as a superset of one (usually with a lower difficulty). Expanded loadouts that are not there yet are added with a
+//difficulty of -1. Loadouts absorbed by another with a known difficulty that is not higher are dropped
+ParsedEntry RegenerateEntry(const LogicEntry& entry, const ParsedEntry* previous, DnfBuilder& dnf_builder, RegenerateCounts& counts) {
+	const Dnf* expanded;
+	try {
+		expanded = &dnf_builder.SplitLogicStatement(entry.logic);
+	} catch (const exception& e) {
+		throw logic_error(entry.name + ": " + e.what());
+	}
 
-	AppendParsedLogic("DASH", "Mothwing_Cloak", "macro", macros);
-	AppendParsedLogic("CLAW", "Mantis_Claw", "macro", macros);
-	AppendParsedLogic("DREAMNAIL", "Dream_Nail", "macro", macros);
-	AppendParsedLogic("SUPERDASH", "Crystal_Heart", "macro", macros);
-	AppendParsedLogic("ACID", "Isma's_Tear", "macro", macros);
-	AppendParsedLogic("WINGS", "Monarch_Wings", "macro", macros);
-	AppendParsedLogic("FIREBALL", "Vengeful_Spirit", "macro", macros);
-	AppendParsedLogic("QUAKE", "Desolate_Dive", "macro", macros);
-	AppendParsedLogic("SCREAM", "Howling_Wraiths", "macro", macros);
+	struct Candidate {
+		Conjunction conjunction;
+		const ParsedLoadout* previous;
+	};
+	vector<Candidate> candidates;
+	vector<bool> expanded_found(expanded->size(), false);
+	vector<LogicToken> tokens;
+	int previous_count = previous != nullptr ? (int) previous->loadouts.size() : 0;
+	for (int i = 0; i < previous_count; i++) {
+		Conjunction conjunction = ReadLoadout(previous->loadouts[i], dnf_builder, tokens);
+		bool allowed = false;
+		for (size_t e = 0; e < expanded->size(); e++) {
+			const vector<int>& sorted = (*expanded)[e].sorted;
+			expanded_found[e] = expanded_found[e] || sorted == conjunction.sorted;
+			allowed = allowed || includes(conjunction.sorted.begin(), conjunction.sorted.end(), sorted.begin(), sorted.end());
+		}
+		if (allowed) {
+			candidates.push_back({ move(conjunction), &previous->loadouts[i] });
+		}
+	}
+	for (size_t e = 0; e < expanded->size(); e++) {
+		if (!expanded_found[e]) {
+			candidates.push_back({ (*expanded)[e], nullptr });
+			candidates.back().conjunction.difficulty = -1;
+		}
+	}
 
-	return parsed_logic_doc;
+	vector<Candidate> kept;
+	for (auto& candidate : candidates) {
+		if (any_of(kept.begin(), kept.end(), [&](const Candidate& existing) { return Absorbs(existing.conjunction, candidate.conjunction); })) {
+			continue;
+		}
+		kept.erase(remove_if(kept.begin(), kept.end(), [&](const Candidate& existing) { return Absorbs(candidate.conjunction, existing.conjunction); }), kept.end());
+		kept.push_back(move(candidate));
+	}
+
+	ParsedEntry res;
+	res.source_hash = HexHash(EntrySourceHash(entry));
+	int previous_kept = 0;
+	for (auto& candidate : kept) {
+		if (candidate.previous != nullptr) {
+			res.loadouts.push_back(*candidate.previous);
+			previous_kept++;
+			continue;
+		}
+		string text;
+		for (int literal : candidate.conjunction.literals) {
+			if (!text.empty()) {
+				text += " + ";
+			}
+			text += dnf_builder.literal_names[literal];
+		}
+		res.loadouts.push_back({ text, -1 });
+		counts.loadouts_new++;
+	}
+	counts.loadouts_kept += previous_kept;
+	counts.loadouts_dropped += previous_count - previous_kept;
+	counts.entries_expanded++;
+	return res;
 }
 
+//Rewrites parsed.xml from the logic files, only expanding the entries whose logic changed since it was last written
+//and keeping the difficulties of loadouts that are still there. The file is replaced once it is fully written
+RegenerateCounts RegenerateParsedLogic(const vector<LogicEntry>& entries, const string& path, size_t max_loadouts) {
+	ParsedEntries previous = ReadParsedLogic(path);
+	vector<ParsedEntry> regenerated(entries.size());
+	vector<int> changed;
+	for (int i = 0; i < (int) entries.size(); i++) {
+		auto found = previous.find({ entries[i].is_location, entries[i].name });
+		if (found != previous.end() && found->second.source_hash == HexHash(EntrySourceHash(entries[i]))) {
+			regenerated[i] = move(found->second);
+			previous.erase(found);
+		} else {
+			changed.push_back(i);
+		}
+	}
+
+	int worker_count = RandoRater::DefaultWorkerCount();
+	vector<DnfBuilder> dnf_builders(worker_count);
+	vector<RegenerateCounts> worker_counts(worker_count);
+	RandoRater::ParallelFor((int) changed.size(), worker_count, [&](int worker, int index) {
+		const LogicEntry& entry = entries[changed[index]];
+		auto found = previous.find({ entry.is_location, entry.name });
+		dnf_builders[worker].max_loadouts = max_loadouts;
+		dnf_builders[worker].absorb = false;
+		regenerated[changed[index]] = RegenerateEntry(entry, found != previous.end() ? &found->second : nullptr, dnf_builders[worker], worker_counts[worker]);
+	});
+
+	RegenerateCounts counts;
+	for (auto& worker : worker_counts) {
+		counts.entries_expanded += worker.entries_expanded;
+		counts.loadouts_kept += worker.loadouts_kept;
+		counts.loadouts_new += worker.loadouts_new;
+		counts.loadouts_dropped += worker.loadouts_dropped;
+	}
+	for (int i : changed) {
+		previous.erase({ entries[i].is_location, entries[i].name });
+	}
+	for (auto& removed : previous) { //entries no longer in the logic files
+		counts.loadouts_dropped += (int) removed.second.loadouts.size();
+	}
+
+	pugi::xml_document parsed_logic_doc;
+	pugi::xml_node locs = parsed_logic_doc.append_child("locations"), macros = parsed_logic_doc.append_child("macros");
+	for (size_t i = 0; i < entries.size(); i++) {
+		pugi::xml_node output = (entries[i].is_location ? locs : macros).append_child(entries[i].is_location ? "location" : "macro");
+		output.append_attribute("name").set_value(entries[i].name.c_str());
+		output.append_attribute("source").set_value(regenerated[i].source_hash.c_str());
+		for (auto& loadout : regenerated[i].loadouts) {
+			pugi::xml_node loadout_container = output.append_child("loadout");
+			loadout_container.append_attribute("difficulty").set_value(loadout.difficulty);
+			loadout_container.text().set(loadout.text.c_str());
+		}
+	}
+
+	string temp_path = path + ".tmp";
+	if (!parsed_logic_doc.save_file(temp_path.c_str())) {
+		throw ios_base::failure("Unable to write " + temp_path);
+	}
+	remove(path.c_str()); //rename does not replace existing files on Windows
+	if (rename(temp_path.c_str(), path.c_str()) != 0) {
+		throw ios_base::failure("Unable to replace " + path);
+	}
+	return counts;
+}
 
+int main(int argc, char** argv) {
+	DnfBuilder dnf_builder;
+	int bench_repetitions = 0;
+	const char* regenerate = nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--max-loadouts") == 0 && i + 1 < argc) {
+			dnf_builder.max_loadouts = strtoul(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "--bench") == 0) {
+			bench_repetitions = i + 1 < argc && isdigit((unsigned char) argv[i + 1][0]) ? max(1, atoi(argv[++i])) : 100;
+		} else if (strcmp(argv[i], "--regenerate") == 0) {
+			regenerate = i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0 ? argv[++i] : "XML/parsed.xml";
+		}
+	}
 
-int main() {
-	CreateParsedLogic();
+	try {
+		vector<LogicEntry> entries = ReadLogicSources();
+		if (bench_repetitions > 0) {
+			BenchmarkParsedLogic(entries, bench_repetitions, dnf_builder.max_loadouts);
+			return 0;
+		} else if (regenerate != nullptr) {
+			RegenerateCounts counts = RegenerateParsedLogic(entries, regenerate, dnf_builder.max_loadouts);
+			cout << "Regenerated " << regenerate << ": expanded " << counts.entries_expanded << " of " << entries.size() << " entries, "
+				<< counts.loadouts_kept << " loadouts kept their difficulty, " << counts.loadouts_new << " new (difficulty -1), "
+				<< counts.loadouts_dropped << " dropped" << endl;
+			return 0;
+		}
+		CreateParsedLogic(entries, dnf_builder);
+	} catch (const exception& e) {
+		cout << e.what() << endl;
+		return 1;
+	}
+	cout << "Loadouts: " << dnf_builder.loadouts_before << " before minimization, " << dnf_builder.loadouts_after << " after" << endl;
 
 	return 0;
 }
\ No newline at end of file
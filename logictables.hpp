@@ -0,0 +1,104 @@
+#pragma once
+
+//Generated by logiccodegen.cpp, do not edit by hand
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace RandoRater {
+
+	inline std::unordered_set<std::string_view> default_grub_locations {
+		"Grub-Greenpath_Stag",
+		"Grub-Hive_Internal",
+		"Grub-City_of_Tears_Guarded",
+		"Grub-Crossroads_Center",
+		"Grub-Collector_3",
+		"Grub-Waterways_East",
+		"Grub-King's_Station",
+		"Grub-Soul_Sanctum",
+		"Grub-Crossroads_Spike",
+		"Grub-Howling_Cliffs",
+		"Grub-Queen's_Gardens_Stag",
+		"Grub-Dark_Deepnest",
+		"Grub-Fog_Canyon",
+		"Grub-Waterways_Main",
+		"Grub-Crystal_Peak_Spike",
+		"Grub-Deepnest_Nosk",
+		"Grub-Crystal_Peak_Crushers",
+		"Grub-Crossroads_Guarded",
+		"Grub-Resting_Grounds",
+		"Grub-Waterways_Requires_Tram",
+		"Grub-Crystal_Peak_Mimic",
+		"Grub-Fungal_Spore_Shroom",
+		"Grub-Basin_Requires_Wings",
+		"Grub-Greenpath_MMC",
+		"Grub-City_of_Tears_Left",
+		"Grub-Crossroads_Acid",
+		"Grub-Basin_Requires_Dive",
+		"Grub-Hallownest_Crown",
+		"Grub-Queen's_Gardens_Marmu",
+		"Grub-Crossroads_Stag",
+		"Grub-Fungal_Bouncy",
+		"Grub-Crystal_Peak_Below_Chest",
+		"Grub-Collector_1",
+		"Grub-Greenpath_Cornifer",
+		"Grub-Watcher's_Spire",
+		"Grub-Hive_External",
+		"Grub-Deepnest_Mimic",
+		"Grub-Crystal_Heart",
+		"Grub-Kingdom's_Edge_Camp",
+		"Grub-Deepnest_Spike",
+		"Grub-Kingdom's_Edge_Oro",
+		"Grub-Collector_2",
+		"Grub-Beast's_Den",
+		"Grub-Queen's_Gardens_Top",
+		"Grub-Greenpath_Journal"
+	};
+	inline std::unordered_map<std::string_view, int> default_essence_rewards {
+		std::make_pair("Whispering_Root-Kingdoms_Edge", 51),
+		std::make_pair("Whispering_Root-Ancestral_Mound", 42),
+		std::make_pair("Whispering_Root-Hive", 20),
+		std::make_pair("Whispering_Root-City", 28),
+		std::make_pair("Whispering_Root-Waterways", 35),
+		std::make_pair("Whispering_Root-Crossroads", 29),
+		std::make_pair("Whispering_Root-Greenpath", 44),
+		std::make_pair("Whispering_Root-Leg_Eater", 20),
+		std::make_pair("Whispering_Root-Spirits_Glade", 34),
+		std::make_pair("Whispering_Root-Queens_Gardens", 29),
+		std::make_pair("Whispering_Root-Resting_Grounds", 20),
+		std::make_pair("Whispering_Root-Mantis_Village", 18),
+		std::make_pair("Whispering_Root-Howling_Cliffs", 46),
+		std::make_pair("Whispering_Root-Deepnest", 45),
+		std::make_pair("Whispering_Root-Crystal_Peak", 21),
+		std::make_pair("Elder_Hu", 100),
+		std::make_pair("Galien", 200),
+		std::make_pair("Gorb", 100),
+		std::make_pair("Markoth", 250),
+		std::make_pair("Marmu", 150),
+		std::make_pair("No_Eyes", 200),
+		std::make_pair("Xero", 100)
+	};
+	inline std::unordered_map<std::string_view, std::string> misc_charms {
+		std::make_pair("Shaman_Stone", "Salubra"),
+		std::make_pair("Quick_Slash", "Quick_Slash"),
+		std::make_pair("Fragile_Strength", "Leg_Eater"),
+		std::make_pair("Hiveblood", "Hiveblood")
+	};
+	inline std::unordered_set<std::string> ignored_macros {
+		"MILDSKIPS",
+		"FIREBALLSKIPS",
+		"SHADESKIPS",
+		"ACIDSKIPS",
+		"SPIKETUNNELS",
+		"SPICYSKIPS",
+		"DARKROOMS",
+		"CURSED",
+		"NOTCURSED",
+		"Focus",
+		"GRUBCOUNT",
+		"ESSENCECOUNT",
+		"200ESSENCE"
+	};
+}
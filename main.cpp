@@ -1,597 +1,548 @@
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <unordered_map>
 #include <memory>
-#include <unordered_set>
 #include <algorithm>
 #include <vector>
 #include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <sstream>
+#include <chrono>
 
 #include "pugixml.hpp"
+#include "compiledlogic.hpp"
+#include "logiccache.hpp"
+#include "threadpool.hpp"
+#include "corpus.hpp"
+#include "rater.hpp"
+#include "percentile.hpp"
+#include "profiles.hpp"
+#include "specializedlogic.hpp"
+#include "server.hpp"
+#include "watcher.hpp"
 
 namespace RandoRater {
 
-	const long long int kBigNumber = 1000000000000;
-	const bool DEBUG = false;
-
-	const long long int kTensTable[11] = {
-		0,
-		10,
-		100,
-		1000,
-		10000,
-		100000,
-		1000000,
-		10000000,
-		100000000,
-		1000000000,
-		10000000000
-	};
-
-	enum class ItemCost { //Simple keys as cost are defined as macros
-		kGrub, kEssence, kOther
-	};
-	struct Item {
-		std::string name;
-		std::string location;
-		ItemCost cost_type;
-		int cost;
-		Item() : name(""), location(""), cost_type(ItemCost::kOther), cost(0) {}
-		Item(std::string vanilla_item) : name(vanilla_item), location(vanilla_item), cost_type(ItemCost::kOther), cost(0) {}
-		Item(std::string name, std::string location) : name(name), location(location), cost_type(ItemCost::kOther), cost(0) {}
-		bool operator==(const Item& other) const {
-			return name == other.name && location == other.location;
-		}
-	};
-	struct ItemHasher {
-		std::size_t operator()(const Item& item) const {
-			return std::hash<std::string>()(item.name);
-		}
-	};
-	struct LoadoutRating {
-		int rating;
-		std::unique_ptr<std::vector<std::string>> loadout;
-		LoadoutRating(int rating, std::unique_ptr<std::vector<std::string>> loadout) : rating(rating), loadout(std::move(loadout)) {}
-	};
-	struct RandoSettings {
-		std::string start_location;
-		bool randomized_grubs, randomized_roots;
-	};
-	std::unordered_map<std::string, std::string> start_location_lookup {
-		std::make_pair("King's Pass", "King's_Pass"),
-		std::make_pair("Stag Nest", "Stag_Nest"),
-		std::make_pair("West Crossroads", "Crossroads"),
-		std::make_pair("East Crossroads", "Crossroads"),
-		std::make_pair("Ancestral Mound", "Ancestral_Mound"),
-		std::make_pair("West Fog Canyon", "Left_Fog_Canyon"),
-		std::make_pair("East Fog Canyon", "Right_Fog_Canyon"),
-		std::make_pair("Queen's Station", "Queen's_Station"),
-		std::make_pair("Fungal Wastes", "Fungal_Wastes"),
-		std::make_pair("Fungal Core", "Fungal_Core"),
-		std::make_pair("Distant Village", "Distant_Village"),
-		std::make_pair("Abyss", "Abyss"),
-		std::make_pair("Hive", "Hive"),
-		std::make_pair("Kingdom's Edge", "Central_Kingdom's_Edge"),
-		std::make_pair("Hallownest's Crown", "Hallownest's_Crown"),
-		std::make_pair("Crystallized Mound", "Crystallized_Mound"),
-		std::make_pair("Royal Waterways", "Upper_Left_Waterways"),
-		std::make_pair("Queen's Gardens", "Top_Left_Queen's_Gardens"),
-		std::make_pair("Far Greenpath", "Greenpath"),
-		std::make_pair("Greenpath", "Greenpath"),
-		std::make_pair("City Storerooms", "Left_Elevator"),
-		std::make_pair("King's Station", "Upper_King's_Station"),
-		std::make_pair("Outside Colosseum", "Top_Kingdom's_Edge"),
-		std::make_pair("City of Tears", "Left_City")
-	};
-	std::unordered_set<std::string> default_grub_locations {
-		"Grub-Greenpath_Stag",
-		"Grub-Hive_Internal",
-		"Grub-City_of_Tears_Guarded",
-		"Grub-Crossroads_Center",
-		"Grub-Collector_3",
-		"Grub-Waterways_East",
-		"Grub-King's_Station",
-		"Grub-Soul_Sanctum",
-		"Grub-Crossroads_Spike",
-		"Grub-Howling_Cliffs",
-		"Grub-Queen's_Gardens_Stag",
-		"Grub-Dark_Deepnest",
-		"Grub-Fog_Canyon",
-		"Grub-Waterways_Main",
-		"Grub-Crystal_Peak_Spike",
-		"Grub-Deepnest_Nosk",
-		"Grub-Crystal_Peak_Crushers",
-		"Grub-Crossroads_Guarded",
-		"Grub-Resting_Grounds",
-		"Grub-Waterways_Requires_Tram",
-		"Grub-Crystal_Peak_Mimic",
-		"Grub-Fungal_Spore_Shroom",
-		"Grub-Basin_Requires_Wings",
-		"Grub-Greenpath_MMC",
-		"Grub-City_of_Tears_Left",
-		"Grub-Crossroads_Acid",
-		"Grub-Basin_Requires_Dive",
-		"Grub-Hallownest_Crown",
-		"Grub-Queen's_Gardens_Marmu",
-		"Grub-Crossroads_Stag",
-		"Grub-Fungal_Bouncy",
-		"Grub-Crystal_Peak_Below_Chest",
-		"Grub-Collector_1",
-		"Grub-Greenpath_Cornifer",
-		"Grub-Watcher's_Spire",
-		"Grub-Hive_External",
-		"Grub-Deepnest_Mimic",
-		"Grub-Crystal_Heart",
-		"Grub-Kingdom's_Edge_Camp",
-		"Grub-Deepnest_Spike",
-		"Grub-Kingdom's_Edge_Oro",
-		"Grub-Collector_2",
-		"Grub-Beast's_Den",
-		"Grub-Queen's_Gardens_Top",
-		"Grub-Greenpath_Journal"
-	};
-	std::unordered_map<std::string, int> default_essence_rewards {
-		std::make_pair("Whispering_Root-Kingdoms_Edge", 51),
-		std::make_pair("Whispering_Root-Ancestral_Mound", 42),
-		std::make_pair("Whispering_Root-Hive", 20),
-		std::make_pair("Whispering_Root-City", 28),
-		std::make_pair("Whispering_Root-Waterways", 35),
-		std::make_pair("Whispering_Root-Crossroads", 29),
-		std::make_pair("Whispering_Root-Greenpath", 44),
-		std::make_pair("Whispering_Root-Leg_Eater", 20),
-		std::make_pair("Whispering_Root-Spirits_Glade", 34),
-		std::make_pair("Whispering_Root-Queens_Gardens", 29),
-		std::make_pair("Whispering_Root-Resting_Grounds", 20),
-		std::make_pair("Whispering_Root-Mantis_Village", 18),
-		std::make_pair("Whispering_Root-Howling_Cliffs", 46),
-		std::make_pair("Whispering_Root-Deepnest", 45),
-		std::make_pair("Whispering_Root-Crystal_Peak", 21),
-		std::make_pair("Elder_Hu", 100),
-		std::make_pair("Galien", 200),
-		std::make_pair("Gorb", 100),
-		std::make_pair("Markoth", 250),
-		std::make_pair("Marmu", 150),
-		std::make_pair("No_Eyes", 200),
-		std::make_pair("Xero", 100)
-	};
-	std::unordered_map<std::string, std::string> misc_charms {
-		std::make_pair("Shaman_Stone", "Salubra"),
-		std::make_pair("Quick_Slash", "Quick_Slash"),
-		std::make_pair("Fragile_Strength", "Leg_Eater"),
-		std::make_pair("Hiveblood", "Hiveblood")
-	};
-	std::unordered_set<std::string> ignored_macros {
-		"MILDSKIPS",
-		"FIREBALLSKIPS",
-		"SHADESKIPS",
-		"ACIDSKIPS",
-		"SPIKETUNNELS",
-		"SPICYSKIPS",
-		"DARKROOMS",
-		"CURSED",
-		"NOTCURSED",
-		"Focus",
-		"GRUBCOUNT",
-		"ESSENCECOUNT",
-		"200ESSENCE"
+	enum class BatchFormat {
+		kCsv, kJsonl
 	};
 
-	std::ofstream LOGGER("log.txt");
 	struct RaterSettings {
 		bool ignore_bad_difficulty = false;
-		char* path = nullptr;
-	} RATER_SETTINGS;
-
-	void SpaceToUnderscore(std::string& str) {
-		for (int i = 0; i < str.length(); i++)
-			if (str[i] == ' ')
-				str[i] = '_';
-	}
-
-	std::unique_ptr<std::vector<std::string>> GetSpoilerLog() {
-		const char* path_stem = getenv("USERPROFILE");
-		if (path_stem == nullptr) {
-			return nullptr;
-		}
-		std::ifstream spoiler_log(std::string(path_stem) + "\\AppData\\LocalLow\\Team Cherry\\Hollow Knight\\RandomizerSpoilerLog.txt");
-		auto res = std::make_unique<std::vector<std::string>>();
+		bool compile_logic = false; //rewrite the compiled logic cache and exit
+		const char* log = nullptr; //spoiler log to rate, "-" for stdin and the user's own if not set
+		const char* batch = nullptr; //directory or file listing spoiler logs to rate instead
+		const char* watch = nullptr; //spoiler log to rate again every time it is written
+		const char* serve = nullptr; //Unix domain socket to answer rating requests on, "-" for stdin and stdout
+		BatchFormat batch_format = BatchFormat::kCsv;
+		int threads = 0; //0 for one per core
+		EvaluationMode evaluation_mode = EvaluationMode::kFixpoint;
+		int percentile_samples = 0; //random placements to compare the seed with, 0 to only rate the seed
+		const char* report = nullptr; //per check sphere and rating of the seed, in batch_format, "-" for stdout
+		bool full_map = false; //report checks taken after Radiance too
+		std::vector<const char*> profiles; //"name=spec" to rate the seed with besides the default, see ParseRatingProfile
+		uint64_t sample_seed = 0;
+		bool stats = false; //print phase times and counters to stderr, needs a RANDORATER_STATS build
+		const char* trace = nullptr; //Chrome trace of the run, also needs a RANDORATER_STATS build
+	};
 
-		std::string cur_line = "";
-		while (getline(spoiler_log, cur_line)) {
-			res->push_back(cur_line);
+	CompiledLogic BuildLookupTable(const RaterSettings& rater_settings, bool rewrite_cache) {
+		RANDORATER_PHASE(kPhaseLoadLogic);
+#if defined(RANDORATER_EMBEDDED_LOGIC)
+		if (!rewrite_cache && rater_settings.ignore_bad_difficulty == kEmbeddedIgnoreBadDifficulty) {
+			return EmbeddedLogic();
 		}
-
-		spoiler_log.close();
-		return res;
+#endif
+		return LoadLogic(kParsedLogicPath, kCompiledLogicPath, DefaultCompileOptions(rater_settings.ignore_bad_difficulty), rewrite_cache);
 	}
 
-	Item ParseRegularItem(std::string& log_line) {
-		Item item;
-		int i = 0;
-		while (log_line.at(i) != ')') { i++; }
-		i += 2;
-		while (log_line.at(i) != '<') {
-			char c = log_line.at(i++);
-			item.name += c == ' ' ? '_' : c;
+	void WriteCsvField(std::ostream& out, const std::string& field) {
+		if (field.find_first_of(",\"\r\n") == std::string::npos) {
+			out << field;
+			return;
 		}
-		i += 10;
-		while (i < log_line.length() && log_line.at(i) != '[') {
-			char c = log_line.at(i++);
-			item.location += c == ' ' ? '_' : c;
-		}
-		if (i < log_line.length()) {
-			item.location = item.location.substr(0, item.location.length() - 1); //get rid of space between item and '[cost]'
-			i++;
-			while (log_line.at(i) != ' ') {
-				item.cost = item.cost * 10 + (log_line.at(i++) - '0');
+		out << '"';
+		for (char c : field) {
+			out << c;
+			if (c == '"') {
+				out << '"';
 			}
-			std::string cost_type_short = log_line.substr(i + 1, 2);
-			if (cost_type_short == "Gr")
-				item.cost_type = ItemCost::kGrub;
-			else if (cost_type_short == "Es")
-				item.cost_type = ItemCost::kEssence;
 		}
+		out << '"';
+	}
 
-		if (item.name.at(item.name.length() - 1) == ')') { //dupe item
-			item.name = item.name.substr(0, item.name.length() - 4);
+	void WriteJsonString(std::ostream& out, const std::string& str) {
+		out << '"';
+		for (unsigned char c : str) {
+			if (c == '"' || c == '\\') {
+				out << '\\' << c;
+			} else if (c < 0x20) {
+				const char* hex = "0123456789abcdef";
+				out << "\\u00" << hex[c >> 4] << hex[c & 15];
+			} else {
+				out << c;
+			}
 		}
+		out << '"';
+	}
 
-		if (item.location == "King's_Idol-Glade_of_Hope") {
-			item.cost_type = ItemCost::kEssence;
-			item.cost = 200;
+	//Log10 rating for the console, where a seed that cannot be completed says so instead of printing nan
+	std::string RatingText(long long int raw) {
+		if (raw < 0) {
+			return "cannot be completed";
 		}
-
-		return item;
+		std::ostringstream text;
+		text << Log10Rating(raw);
+		return text.str();
 	}
 
-	int AddProgression(std::vector<std::string>& spoiler_log, std::unordered_set<Item, ItemHasher>& item_locations, int progression_start = 0) {
-		int i = progression_start;
-		while (spoiler_log[i] != "PROGRESSION ITEMS") { i++; }
-		i++;
-		for (; spoiler_log[i] != "ALL ITEMS"; i++) {
-			if (spoiler_log[i].length() == 0) continue;
-			item_locations.insert(ParseRegularItem(spoiler_log[i]));
+	//One line per seed, written in whatever order the seeds finish
+	void WriteBatchResult(std::ostream& out, BatchFormat format, const std::string& path, const SeedRating& rating, const std::string& error) {
+		if (format == BatchFormat::kCsv) {
+			WriteCsvField(out, path);
+			out << ',' << rating.raw << ',';
+			if (rating.raw >= 0) {
+				out << Log10Rating(rating.raw);
+			}
+			out << ',' << rating.checks_taken << ',';
+			WriteCsvField(out, error);
+		} else {
+			out << "{\"path\":";
+			WriteJsonString(out, path);
+			out << ",\"raw_rating\":" << rating.raw << ",\"log10_rating\":";
+			if (rating.raw >= 0) {
+				out << Log10Rating(rating.raw);
+			} else {
+				out << "null";
+			}
+			out << ",\"checks_taken\":" << rating.checks_taken;
+			if (!error.empty()) {
+				out << ",\"error\":";
+				WriteJsonString(out, error);
+			}
+			out << '}';
 		}
-		return i;
+		out << '\n';
 	}
 
-	int AddMiscItems(std::vector<std::string>& spoiler_log, std::unordered_set<Item, ItemHasher>& item_locations, int all_items_start = 0) {
-		int i = all_items_start;
-		while (spoiler_log[i] != "ALL ITEMS") { i++; }
-		i++;
-		std::string cur_area = "";
-		for (; spoiler_log[i] != "SETTINGS"; i++) {
-			if (spoiler_log[i].length() == 0) continue;
-			int colon_pos = spoiler_log[i].find(':');
-			if (colon_pos != std::string::npos) {
-				if (spoiler_log[i].at(0) == '(') {
-					int j = 0;
-					while (spoiler_log[i].at(j) != ')') { j++; }
-					cur_area = spoiler_log[i].substr(j + 2, spoiler_log[i].length() - j - 3);
-				} else {
-					cur_area = spoiler_log[i].substr(0, spoiler_log[i].length() - 1);
+	//One line per check, in the order they were taken and then the checks that never were
+	void WriteCheckReport(std::ostream& out, BatchFormat format, const CompiledLogic& logic, const std::vector<Placement>& placements,
+		const std::vector<CheckReport>& report) {
+		std::vector<int> order(placements.size());
+		for (int p = 0; p < (int) order.size(); p++) {
+			order[p] = p;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+			return (unsigned int) report[a].step < (unsigned int) report[b].step; //-1 sorts last
+		});
+		if (format == BatchFormat::kCsv) {
+			out << "location,item,step,sphere,raw_rating,log10_rating,loadout\n";
+		}
+		std::string loadout;
+		for (int p : order) {
+			const CheckReport& check = report[p];
+			loadout.clear();
+			if (check.loadout >= 0) {
+				const LoadoutTable& table = logic.location_logic;
+				for (int s = table.loadout_begin[check.loadout]; s < table.loadout_begin[check.loadout + 1]; s++) {
+					loadout += loadout.empty() ? "" : " + ";
+					loadout += logic.symbols.Name(table.symbols[s]);
+				}
+			}
+			std::string location(placements[p].source->location), item(placements[p].source->name);
+			if (format == BatchFormat::kCsv) {
+				WriteCsvField(out, location);
+				out << ',';
+				WriteCsvField(out, item);
+				out << ',' << check.step << ',' << check.sphere << ',' << check.rating << ',';
+				if (check.rating >= 0) {
+					out << Log10Rating(check.rating);
 				}
-				SpaceToUnderscore(cur_area);
+				out << ',';
+				WriteCsvField(out, loadout);
 			} else {
-				if (spoiler_log[i].at(0) == '(') {
-					Item item = ParseRegularItem(spoiler_log[i]);
-					if (misc_charms.count(item.name) || item.name.compare(0, 8, "Pale_Ore") == 0) {
-						item_locations.insert(item);
-					}
+				out << "{\"location\":";
+				WriteJsonString(out, location);
+				out << ",\"item\":";
+				WriteJsonString(out, item);
+				out << ",\"step\":" << check.step << ",\"sphere\":" << check.sphere << ",\"raw_rating\":" << check.rating << ",\"log10_rating\":";
+				if (check.rating >= 0) {
+					out << Log10Rating(check.rating);
 				} else {
-					int j = 0;
-					while (j < spoiler_log[i].length() && spoiler_log[i].at(j) != '[') { j++; }
-					if (spoiler_log[i].at(j) != '[') {
-						throw std::logic_error("Bad line : " + spoiler_log[i]);
-					}
-					std::string item_name = spoiler_log[i].substr(0, j - 1);
-					SpaceToUnderscore(item_name);
-					if (misc_charms.count(item_name)) {
-						item_locations.insert(Item(item_name, cur_area));
-					}
+					out << "null";
 				}
+				out << ",\"loadout\":";
+				WriteJsonString(out, loadout);
+				out << '}';
 			}
+			out << '\n';
 		}
-		return i;
+		out.flush();
 	}
 
-	RandoSettings ParseSettings(std::vector<std::string>& spoiler_log, int settings_start = 0) {
-		RandoSettings res;
-		int i = settings_start;
-		while (spoiler_log[i] != "SETTINGS") { i++; }
-		i += 2;
-		if (spoiler_log[i].substr(6) != "Item Randomizer") {
-			throw std::logic_error("Modes other than Item Randomizer not supported");
-		}
-		i += 2;
-		if (spoiler_log[i].length() < 16) {
-			throw std::logic_error("Error parsing spoiler log (start location)");
-		}
-		try {
-			res.start_location = start_location_lookup.at(spoiler_log[i].substr(16));
-		} catch (std::out_of_range e) {
-			throw std::logic_error("Unknown start location: " + spoiler_log[i].substr(16));
-		}
-		i += 11;
-		for (; spoiler_log[i] != "QUALITY OF LIFE"; i++) {
-			int j = spoiler_log[i].find(':');
-			if (spoiler_log[i].compare(0, j, "Grubs") == 0) {
-				res.randomized_grubs = spoiler_log[i].compare(j + 2, 4, "True") == 0;
-			} else if (spoiler_log[i].compare(0, j, "Whispering roots") == 0) {
-				res.randomized_roots = spoiler_log[i].compare(j + 2, 4, "True") == 0;
-			}
-		}
-		return res;
-	}
-
-	auto ConvertXMLToLoadoutRating(pugi::xml_node root) {
-		auto res = std::make_unique<std::unordered_map<std::string, std::unique_ptr<std::vector<LoadoutRating>>>>();
-		for (auto location = root.first_child(); location; location = location.next_sibling()) {
-			auto ratings = std::make_unique<std::vector<LoadoutRating>>();
-			for (auto loadout = location.first_child(); loadout; loadout = loadout.next_sibling()) {
-				auto split_logic = std::make_unique<std::vector<std::string>>();
-				std::string logic = loadout.text().as_string();
-				int symbol_start = 0;
-				for (int i = 0; i < logic.length(); i++) {
-					if (logic[i] == '+') {
-						split_logic->push_back(logic.substr(symbol_start, i - symbol_start - 1));
-						symbol_start = i + 2;
-						i++;
-					}
+	//Rates every seed in the batch against one shared lookup table, specialized once per start location and shared by
+	//every seed starting there. The batch is a directory, a file listing spoiler logs or a seed corpus, whose tokenized
+	//logs are rated without parsing them. A seed that fails to parse or rate gets a result with the error instead of
+	//stopping the batch
+	void RateBatch(const RaterSettings& rater_settings, const CompiledLogic& logic, std::ostream& out) {
+		std::unique_ptr<SeedCorpus> corpus;
+		std::vector<std::string> paths;
+		if (IsSeedCorpus(rater_settings.batch)) {
+			corpus = std::make_unique<SeedCorpus>(rater_settings.batch);
+		} else {
+			paths = GetBatchPaths(rater_settings.batch);
+		}
+		if (rater_settings.batch_format == BatchFormat::kCsv) {
+			out << "path,raw_rating,log10_rating,checks_taken,error\n";
+		}
+		std::mutex out_lock;
+		int worker_count = rater_settings.threads > 0 ? rater_settings.threads : DefaultWorkerCount();
+		SpecializedLogicCache specialized_logic(logic);
+		std::vector<std::unique_ptr<SpecializedRater>> contexts(worker_count);
+		std::vector<CorpusSeed> corpus_seeds(corpus != nullptr ? worker_count : 0);
+		int count = corpus != nullptr ? corpus->size() : (int) paths.size();
+		ParallelFor(count, worker_count, [&](int worker, int index) { //every worker starts on its own contiguous share of the corpus
+			SeedRating rating;
+			std::string error;
+			std::string path = corpus != nullptr ? std::string(corpus->Name(index)) : paths[index];
+			try {
+				if (contexts[worker] == nullptr) {
+					contexts[worker] = std::make_unique<SpecializedRater>(logic, specialized_logic);
 				}
-				split_logic->push_back(logic.substr(symbol_start));
-				int loadout_rating = loadout.attribute("difficulty").as_int();
-				if (loadout_rating < 0) {
-					if (RATER_SETTINGS.ignore_bad_difficulty) {
-						loadout_rating = 0;
-					} else {
-						std::string err_location = "parsed.xml -> " + std::string(root.name()) + " -> " + location.attribute("name").as_string() + " -> loadout \"" + logic + "\"";
-						throw std::logic_error("Difficulty must be non-negative: " + err_location);
-					}
+				EvaluationOptions options;
+				options.mode = rater_settings.evaluation_mode;
+				if (corpus != nullptr) {
+					CorpusSeed& seed = corpus_seeds[worker];
+					corpus->Read(index, seed);
+					rating = seed.tokenized ? contexts[worker]->RateSeed(seed.settings, seed.items, seed.transitions, options)
+						: contexts[worker]->RateSeed(seed.text, options);
+				} else {
+					auto spoiler_log = ReadSpoilerLog(paths[index]);
+					rating = contexts[worker]->RateSeed(spoiler_log->text, options);
 				}
-				ratings->push_back(LoadoutRating(loadout_rating, std::move(split_logic)));
+			} catch (const std::exception& e) {
+				rating = SeedRating();
+				error = e.what();
 			}
-			res->insert(std::make_pair(location.attribute("name").as_string(), std::move(ratings)));
-		}
-		return res;
+			std::ostringstream line;
+			WriteBatchResult(line, rater_settings.batch_format, path, rating, error);
+			std::lock_guard<std::mutex> guard(out_lock);
+			out << line.str();
+		});
+		out.flush();
 	}
 
-	auto BuildLookupTable(pugi::xml_document& parsed_logic_doc) {
-		return std::make_pair(
-			ConvertXMLToLoadoutRating(parsed_logic_doc.child("locations")),
-			ConvertXMLToLoadoutRating(parsed_logic_doc.child("macros"))
-		);
-	}
-
-	long long int EvaluateMacro(std::string macro,
-		std::unordered_map<std::string, std::unique_ptr<std::vector<LoadoutRating>>>& macro_lookup,
-		std::unordered_map<std::string, long long int>& acquired_items,
-		std::unordered_map<std::string, long long int>& evaluated_items) {
-		if (ignored_macros.count(macro)) {
-			return 0;
-		}
-
-		auto iter = acquired_items.find(macro);
-		if (iter != acquired_items.end()) {
-			return iter->second;
-		}
-
-		iter = evaluated_items.find(macro);
-		if (iter != evaluated_items.end()) {
-			return iter->second;
-		}
+	//Rating buffers of one --serve worker, kept from request to request and made again when the logic is reloaded
+	struct ServeWorker {
+		std::shared_ptr<const CompiledLogic> logic; //the context rates with, kept alive for it
+		std::unique_ptr<RaterContext> context;
+	};
 
-		if (!macro_lookup.count(macro)) { //unacquired item (or typo)
-			return -1;
+	//Answers a --serve request with the same JSON line as --batch --format jsonl, logs sent inline get "-" as their path.
+	//A reload request compiles the logic again and swaps it in once it is ready, requests already running finish on the
+	//logic they started with
+	std::string HandleServeRequest(const RaterSettings& rater_settings, LogicHolder& logic_holder, std::mutex& reload_lock,
+		ServeWorker& worker, const ServeRequest& request) {
+		std::ostringstream response;
+		if (request.kind == "reload") {
+			try {
+				std::lock_guard<std::mutex> guard(reload_lock);
+				auto logic = std::make_shared<const CompiledLogic>(BuildLookupTable(rater_settings, false));
+				response << "{\"reloaded\":true,\"image_size\":" << logic->image_size << "}\n";
+				logic_holder.Set(std::move(logic));
+			} catch (const std::exception& e) {
+				response << "{\"reloaded\":false,\"error\":";
+				WriteJsonString(response, e.what());
+				response << "}\n";
+			}
+			return response.str();
 		}
 
-		bool uncertain = false;
-		evaluated_items.insert(std::make_pair(macro, -2));
-		long long int macro_rating = kBigNumber;
-		for (auto& rating : *(macro_lookup.at(macro))) {
-			long long int loadout_rating = 0;
-			for (auto& symbol : *(rating.loadout)) {
-				try {
-					long long int evaluation = EvaluateMacro(symbol, macro_lookup, acquired_items, evaluated_items);
-					if (evaluation < 0) {
-						if (evaluation == -2) {
-							uncertain = true;
-						}
-						loadout_rating = kBigNumber; //prevents overriding macro_rating with invalid value
-						break;
-					}
-					evaluated_items.insert(std::make_pair(symbol, evaluation));
-					loadout_rating += evaluation;
-				} catch (std::logic_error e) {
-					std::cerr << e.what() << std::endl;
-					throw std::logic_error("Invalid macro in " + macro);
-				}
+		SeedRating rating;
+		std::string error;
+		std::string path = request.kind == "path" ? request.payload : "-";
+		try {
+			std::shared_ptr<const CompiledLogic> logic = logic_holder.Get();
+			if (worker.logic != logic) {
+				worker.context = nullptr; //before the logic it points into can go
+				worker.context = std::make_unique<RaterContext>(*logic);
+				worker.logic = std::move(logic);
+			}
+			EvaluationOptions options;
+			options.mode = rater_settings.evaluation_mode;
+			if (request.kind == "log") {
+				rating = worker.context->RateSeed(request.payload, options);
+			} else if (request.kind == "path") {
+				auto spoiler_log = ReadSpoilerLog(request.payload);
+				rating = worker.context->RateSeed(spoiler_log->text, options);
+			} else {
+				error = "Unknown request kind " + request.kind + " (expected log, path or reload)";
 			}
-			macro_rating = std::min(macro_rating, std::max(loadout_rating, kTensTable[rating.rating]));
+		} catch (const std::exception& e) {
+			rating = SeedRating();
+			error = e.what();
 		}
+		WriteBatchResult(response, BatchFormat::kJsonl, path, rating, error);
+		return response.str();
+	}
 
-		if (macro_rating == kBigNumber) {
-			macro_rating = -1;
+	//Rates the log at path and prints the rating with the time it took, errors are printed instead of stopping since the
+	//log may be rewritten at any time
+	void RateWatchedLog(const RaterSettings& rater_settings, RaterContext& context, const std::string& path) {
+		auto start = std::chrono::steady_clock::now();
+		try {
+			auto spoiler_log = ReadSpoilerLog(path);
+			EvaluationOptions options;
+			options.mode = rater_settings.evaluation_mode;
+			SeedRating results = context.RateSeed(spoiler_log->text, options);
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			std::cout << "Seed rating: " << RatingText(results.raw) << " (raw rating: " << results.raw << ", " << results.checks_taken
+				<< " checks) in " << ms << " ms" << std::endl;
+		} catch (const std::exception& e) {
+			std::cout << e.what() << std::endl;
 		}
+	}
 
-		if (macro_rating > -1) {
-			acquired_items.insert(std::make_pair(macro, macro_rating));
-		} else if (uncertain) {
-			evaluated_items.erase(macro);
+	//Where the seed falls among the random placements, with a histogram of their ratings by order of magnitude. A seed that
+	//cannot be completed has no place among them, only the histogram is written
+	void WritePercentileReport(std::ostream& out, const SeedRating& rating, const PercentileResult& distribution) {
+		int sample_count = (int) distribution.ratings.size();
+		if (rating.raw < 0) {
+			out << "The seed cannot be completed, so it is not compared with the " << sample_count << " random placements of its items";
 		} else {
-			evaluated_items.at(macro) = -1;
+			out << "Harder than " << RatingPercentile(distribution.ratings, rating.raw) << "% of " << sample_count
+				<< " random placements of its items";
+		}
+		if (distribution.uncompletable > 0) {
+			out << " (" << distribution.uncompletable << " samples never drew a completable placement)";
+		}
+		out << '\n';
+		if (sample_count == 0) {
+			return;
 		}
 
-		return macro_rating;
-	}
-
-	long long int EvaluateLocation(std::string location,
-		std::unordered_map<std::string, std::unique_ptr<std::vector<LoadoutRating>>>& location_lookup,
-		std::unordered_map<std::string, std::unique_ptr<std::vector<LoadoutRating>>>& macro_lookup,
-		std::unordered_map<std::string, long long int>& acquired_items,
-		std::unordered_map<std::string, long long int>& evaluated_items) {
-		if (DEBUG) {
-			LOGGER << "Location " << location << std::endl;
-			std::cout << "Location " << location << std::endl;
+		int seed_bucket = rating.raw >= 0 ? (int) Log10Rating(rating.raw) : -1;
+		int first_bucket = (int) Log10Rating(distribution.ratings.front()), last_bucket = (int) Log10Rating(distribution.ratings.back());
+		if (seed_bucket >= 0) {
+			first_bucket = std::min(first_bucket, seed_bucket);
+			last_bucket = std::max(last_bucket, seed_bucket);
 		}
-		auto ratings = location_lookup.find(location);
-		if (ratings == location_lookup.end()) {
-			throw std::logic_error("Unknown location " + location);
+		std::vector<int> counts(last_bucket - first_bucket + 1, 0);
+		for (long long int raw : distribution.ratings) {
+			counts[(int) Log10Rating(raw) - first_bucket]++;
 		}
-		long long int easiest_loadout_rating = kBigNumber;
-		for (auto& rating : *(ratings->second)) {
-			long long int cur_loadout_rating = 0;
-			for (auto& symbol : *(rating.loadout)) {
-				try {
-					long long int symbol_rating = EvaluateMacro(symbol, macro_lookup, acquired_items, evaluated_items);
-					if (symbol_rating < 0) {
-						if (symbol_rating == -1) {
-							evaluated_items.insert(std::make_pair(symbol, -1));
-						}
-						cur_loadout_rating = kBigNumber;
-						break;
-					}
-					evaluated_items.insert(std::make_pair(symbol, symbol_rating));
-					cur_loadout_rating += symbol_rating;
-				} catch (std::logic_error e) {
-					std::cerr << e.what() << std::endl;
-					std::string loadout = "";
-					for (auto& s : *(rating.loadout)) loadout += s + " ";
-					throw std::logic_error("Invalid macro in loadout \"" + loadout + "\" for location " + location);
-				}
+		int most = *std::max_element(counts.begin(), counts.end());
+		for (int b = 0; b < (int) counts.size(); b++) {
+			int bar = most == 0 ? 0 : (counts[b] * 40 + most - 1) / most;
+			out << (first_bucket + b) << '-' << (first_bucket + b + 1) << '\t' << counts[b] << '\t' << std::string(bar, '#');
+			if (first_bucket + b == seed_bucket) {
+				out << " <- this seed";
 			}
-			easiest_loadout_rating = std::min(easiest_loadout_rating, std::max(cur_loadout_rating, kTensTable[rating.rating]));
+			out << '\n';
 		}
-		return easiest_loadout_rating == kBigNumber ? -1 : easiest_loadout_rating;
+		out.flush();
 	}
 
-	long long int RateProgression(pugi::xml_document& ratings, std::unordered_set<Item, ItemHasher>& item_locations,
-		std::unordered_set<std::string>& starting_items) {
-		auto lookup_table = BuildLookupTable(ratings);
-		std::unordered_map<std::string, long long int> symbol_cache {}, acquired_items {};
-		int grub_count = 0, essence_count = 0;
-
-		for (auto& item : starting_items) {
-			acquired_items.insert(std::make_pair(item, 0));
+	//Trace spans point into the logic image, so this has to run before the logic is unloaded
+	void WriteInstrumentation(const RaterSettings& rater_settings) {
+#if defined(RANDORATER_STATS)
+		if (rater_settings.trace != nullptr) {
+			StatsRegistry::Get().WriteTrace(rater_settings.trace);
 		}
-
-		int c = 0;
-		long long int te_rating = -1;
-
-		do {
-			symbol_cache.clear();
-			std::pair<long long int, Item> next_check = std::make_pair(kBigNumber, Item());
-			for (auto& location : item_locations) {
-				long long int rating =
-					((location.cost_type == ItemCost::kGrub && grub_count < location.cost) ||
-						(location.cost_type == ItemCost::kEssence && essence_count < location.cost)) ? -1 :
-					EvaluateLocation(location.location, *(lookup_table.first), *(lookup_table.second), acquired_items, symbol_cache);
-				if (rating < 0) {
-					continue;
-				} else if (rating < next_check.first) {
-					next_check = std::make_pair(rating, location);
-				}
-			}
-			std::string item_at_check = next_check.second.name;
-			if (item_at_check.length() >= 4 && item_at_check.compare(0, 4, "Grub") == 0) {
-				grub_count++;
-			} else if (item_at_check.length() >= 15 && default_essence_rewards.count(item_at_check)) {
-				essence_count += default_essence_rewards.at(item_at_check);
-			}
-
-			if (item_at_check == "Mothwing_Cloak" || item_at_check == "Shade_Cloak") {
-				if (acquired_items.count("Mothwing_Cloak") == 0) {
-					acquired_items.insert(std::make_pair("Mothwing_Cloak", next_check.first));
-				} else if (acquired_items.count("Shade_Cloak") == 0) {
-					acquired_items.insert(std::make_pair("Shade_Cloak", next_check.first));
-				}
-			} else if (item_at_check == "Vengeful_Spirit" || item_at_check == "Shade_Soul") {
-				if (acquired_items.count("Vengeful_Spirit") == 0) {
-					acquired_items.insert(std::make_pair("Vengeful_Spirit", next_check.first));
-				} else if (acquired_items.count("Shade_Soul") == 0) {
-					acquired_items.insert(std::make_pair("Shade_Soul", next_check.first));
-				}
-			} else if (item_at_check == "Desolate_Dive" || item_at_check == "Descending_Dark") {
-				if (acquired_items.count("Desolate_Dive") == 0) {
-					acquired_items.insert(std::make_pair("Desolate_Dive", next_check.first));
-				} else if (acquired_items.count("Descending_Dark") == 0) {
-					acquired_items.insert(std::make_pair("Descending_Dark", next_check.first));
-				}
-			} else if (item_at_check == "Howling_Wraiths" || item_at_check == "Abyss_Shriek") {
-				if (acquired_items.count("Howling_Wraiths") == 0) {
-					acquired_items.insert(std::make_pair("Howling_Wraiths", next_check.first));
-				} else if (acquired_items.count("Abyss_Shriek") == 0) {
-					acquired_items.insert(std::make_pair("Abyss_Shriek", next_check.first));
-				}
-			} else if (item_at_check == "Dream_Nail" || item_at_check == "Dream_Gate" || item_at_check == "Awoken_Dream_Nail") {
-				if (acquired_items.count("Dream_Nail") == 0) {
-					acquired_items.insert(std::make_pair("Dream_Nail", next_check.first));
-				} else if (acquired_items.count("Dream_Gate") == 0) {
-					acquired_items.insert(std::make_pair("Dream_Gate", next_check.first));
-				} else if (acquired_items.count("Awoken_Dream_Nail") == 0) {
-					acquired_items.insert(std::make_pair("Awoken_Dream_Nail", next_check.first));
-				}
-			} else if (item_at_check == "Queen_Fragment" || item_at_check == "King_Fragment" || item_at_check == "Void_Heart") {
-				if (acquired_items.count("Queen_Fragment") == 0) {
-					acquired_items.insert(std::make_pair("Queen_Fragment", next_check.first));
-				} else if (acquired_items.count("King_Fragment") == 0) {
-					acquired_items.insert(std::make_pair("King_Fragment", next_check.first));
-				} else if (acquired_items.count("Void_Heart") == 0) {
-					acquired_items.insert(std::make_pair("Void_Heart", next_check.first));
-				}
-			} else {
-				acquired_items.insert(std::make_pair(item_at_check, next_check.first));
-			}
-			item_locations.erase(next_check.second);
-
-			te_rating = EvaluateLocation("Radiance", *(lookup_table.first), *(lookup_table.second), acquired_items, symbol_cache);
-		} while (!item_locations.empty() && te_rating == -1);
-
-		return te_rating;
+		if (rater_settings.stats) {
+			StatsRegistry::Get().WriteStats(std::cerr);
+		}
+#else
+		(void) rater_settings;
+#endif
 	}
 
 	int main(int argc, char** argv) {
 
+		RaterSettings rater_settings;
 		for (int i = 1; i < argc; i++) {
 			if (strcmp(argv[i], "--ignore-bad-difficulty") == 0) {
-				RATER_SETTINGS.ignore_bad_difficulty = true;
+				rater_settings.ignore_bad_difficulty = true;
+			} else if (strcmp(argv[i], "--compile-logic") == 0) {
+				rater_settings.compile_logic = true;
+			} else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+				rater_settings.log = argv[++i];
+			} else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+				rater_settings.batch = argv[++i];
+			} else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+				i++;
+				if (strcmp(argv[i], "csv") == 0) {
+					rater_settings.batch_format = BatchFormat::kCsv;
+				} else if (strcmp(argv[i], "jsonl") == 0) {
+					rater_settings.batch_format = BatchFormat::kJsonl;
+				} else {
+					std::cout << "Unknown batch format " << argv[i] << " (expected csv or jsonl)" << std::endl;
+					return 1;
+				}
+			} else if (strcmp(argv[i], "--eval") == 0 && i + 1 < argc) {
+				i++;
+				if (strcmp(argv[i], "bitset") == 0) {
+					rater_settings.evaluation_mode = EvaluationMode::kBitset;
+				} else if (strcmp(argv[i], "recursive") == 0) {
+					rater_settings.evaluation_mode = EvaluationMode::kRecursive;
+				} else if (strcmp(argv[i], "fixpoint") == 0) {
+					rater_settings.evaluation_mode = EvaluationMode::kFixpoint;
+				} else {
+					std::cout << "Unknown evaluation mode " << argv[i] << " (expected bitset, fixpoint or recursive)" << std::endl;
+					return 1;
+				}
+			} else if (strcmp(argv[i], "--percentile") == 0 && i + 1 < argc) {
+				rater_settings.percentile_samples = atoi(argv[++i]);
+			} else if (strcmp(argv[i], "--sample-seed") == 0 && i + 1 < argc) {
+				rater_settings.sample_seed = strtoull(argv[++i], nullptr, 10);
+			} else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+				rater_settings.threads = atoi(argv[++i]);
+			} else if (strcmp(argv[i], "--watch") == 0 && i + 1 < argc) {
+				rater_settings.watch = argv[++i];
+			} else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+				rater_settings.serve = argv[++i];
+			} else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc) {
+				rater_settings.report = argv[++i];
+			} else if (strcmp(argv[i], "--full-map") == 0) {
+				rater_settings.full_map = true;
+			} else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+				rater_settings.profiles.push_back(argv[++i]);
+			} else if (strcmp(argv[i], "--stats") == 0) {
+				rater_settings.stats = true;
+			} else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+				rater_settings.trace = argv[++i];
 			}
 		}
 
-		auto spoiler_log = GetSpoilerLog();
+#if defined(RANDORATER_STATS)
+		if (rater_settings.trace != nullptr) {
+			StatsRegistry::Get().EnableTrace();
+		}
+#else
+		if (rater_settings.stats || rater_settings.trace != nullptr) {
+			std::cout << "--stats and --trace need a build with RANDORATER_STATS defined" << std::endl;
+			return 1;
+		}
+#endif
 
-		auto item_locations = std::make_unique<std::unordered_set<Item, ItemHasher>>();
-		int all_items_begin = AddProgression(*spoiler_log, *item_locations);
-		int settings_begin = AddMiscItems(*spoiler_log, *item_locations, all_items_begin);
-		RandoSettings settings = ParseSettings(*spoiler_log, settings_begin);
-		std::unordered_set<std::string> acquired_items { settings.start_location };
-		if (!settings.randomized_grubs) {
-			for (auto& grub : default_grub_locations) {
-				item_locations->insert(Item(grub));
+		if (rater_settings.compile_logic) {
+			try {
+				CompiledLogic logic = BuildLookupTable(rater_settings, true);
+				std::cout << "Compiled " << kParsedLogicPath << " into " << kCompiledLogicPath << " (" << logic.image_size << " bytes)" << std::endl;
+			} catch (const std::exception& e) {
+				std::cout << e.what() << std::endl;
+				exit(1);
 			}
+			return 0;
+		}
+
+		if (rater_settings.watch != nullptr) {
+			try {
+				CompiledLogic logic = BuildLookupTable(rater_settings, false);
+				RaterContext context(logic);
+				std::string path = rater_settings.watch;
+				if (std::filesystem::exists(path)) {
+					RateWatchedLog(rater_settings, context, path);
+				}
+				std::cout << "Watching " << path << std::endl;
+				WatchFile(path, kWatchDebounceMs, [&]() {
+					RateWatchedLog(rater_settings, context, path);
+				});
+			} catch (const std::exception& e) {
+				std::cout << e.what() << std::endl;
+				exit(1);
+			}
+			return 0;
 		}
-		for (auto& essence_reward : default_essence_rewards) {
-			if (!settings.randomized_roots || essence_reward.first.length() < 15) { //only dream warriors if roots are randomized
-				item_locations->insert(Item(essence_reward.first));
+
+		if (rater_settings.serve != nullptr) {
+			try {
+				LogicHolder logic_holder(std::make_shared<const CompiledLogic>(BuildLookupTable(rater_settings, false)));
+				std::mutex reload_lock;
+				int worker_count = rater_settings.threads > 0 ? rater_settings.threads : DefaultWorkerCount();
+				std::vector<ServeWorker> workers(worker_count);
+				Serve(rater_settings.serve, worker_count, [&](int worker, const ServeRequest& request) {
+					return HandleServeRequest(rater_settings, logic_holder, reload_lock, workers[worker], request);
+				});
+				WriteInstrumentation(rater_settings);
+			} catch (const std::exception& e) {
+				std::cout << e.what() << std::endl;
+				exit(1);
 			}
+			return 0;
 		}
 
-		pugi::xml_document ratings;
-		if (!ratings.load_file("XML/parsed.xml")) {
-			throw std::ios_base::failure("Unable to open parsed.xml");
+		if (rater_settings.batch != nullptr) {
+			try {
+				CompiledLogic logic = BuildLookupTable(rater_settings, false);
+				RateBatch(rater_settings, logic, std::cout);
+				WriteInstrumentation(rater_settings);
+			} catch (const std::exception& e) {
+				std::cout << e.what() << std::endl;
+				exit(1);
+			}
+			return 0;
 		}
 
-		long long results = -1;
+		SeedRating results;
 		try {
-			results = RateProgression(ratings, *item_locations, acquired_items);
+			auto spoiler_log = ReadSpoilerLog(rater_settings.log != nullptr ? rater_settings.log : DefaultSpoilerLogPath());
+			CompiledLogic logic = BuildLookupTable(rater_settings, false);
+			std::unique_ptr<std::ofstream> debug_log;
+			if (DEBUG) {
+				debug_log = std::make_unique<std::ofstream>("log.txt");
+			}
+			EvaluationOptions options;
+			options.mode = rater_settings.evaluation_mode;
+			options.debug_log = debug_log.get();
+			std::vector<CheckReport> report;
+			if (rater_settings.report != nullptr) {
+				options.report = &report;
+				options.past_radiance = rater_settings.full_map;
+			}
+			RaterContext context(logic);
+			results = context.RateSeed(spoiler_log->text, options);
+			std::cout << "Seed rating: " << RatingText(results.raw) << " (raw rating: " << results.raw << ")" << std::endl;
+			if (rater_settings.report != nullptr) {
+				if (strcmp(rater_settings.report, "-") == 0) {
+					WriteCheckReport(std::cout, rater_settings.batch_format, logic, context.Placements(), report);
+				} else {
+					std::ofstream report_file(rater_settings.report);
+					if (!report_file) {
+						throw std::ios_base::failure("Unable to open " + std::string(rater_settings.report));
+					}
+					WriteCheckReport(report_file, rater_settings.batch_format, logic, context.Placements(), report);
+				}
+			}
+			if (!rater_settings.profiles.empty()) {
+				std::vector<RatingProfile> profiles;
+				for (const char* spec : rater_settings.profiles) {
+					profiles.push_back(ParseRatingProfile(spec));
+				}
+				std::vector<SeedRating> profile_results = RateSeedProfiles(spoiler_log->text, logic, profiles);
+				for (size_t k = 0; k < profiles.size(); k++) {
+					std::cout << "Profile " << profiles[k].name << ": " << RatingText(profile_results[k].raw) << " (raw rating: " << profile_results[k].raw
+						<< ", checks taken: " << profile_results[k].checks_taken << ")" << std::endl;
+				}
+			}
+			if (rater_settings.percentile_samples > 0) {
+				options.debug_log = nullptr;
+				options.report = nullptr;
+				options.past_radiance = false;
+				PlacementPool pool = ParsePlacementPool(spoiler_log->text);
+				int worker_count = rater_settings.threads > 0 ? rater_settings.threads : DefaultWorkerCount();
+				PercentileResult distribution = RatePlacementDistribution(logic, pool, rater_settings.percentile_samples,
+					rater_settings.sample_seed, worker_count, options);
+				WritePercentileReport(std::cout, results, distribution);
+			}
+			WriteInstrumentation(rater_settings);
 		} catch (const std::exception& e) {
 			std::cout << e.what() << std::endl;
 			exit(1);
 		}
 
-		std::cout << "Seed rating: " << (results == 0 ? 0 : log10(results)) << " (raw rating: " << results << ")" << std::endl;
-
 		return 0;
 	}
 }
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace RandoRater {
+
+	//Read-only view of a whole file, unmapped when destroyed
+	struct MappedFile {
+		const char* data = nullptr;
+		size_t size = 0;
+
+		MappedFile() {}
+		explicit MappedFile(const std::string& path) {
+			Open(path);
+		}
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept {
+			*this = std::move(other);
+		}
+		MappedFile& operator=(MappedFile&& other) noexcept {
+			if (this != &other) {
+				Close();
+				data = other.data;
+				size = other.size;
+				is_open = other.is_open;
+				other.data = nullptr;
+				other.size = 0;
+				other.is_open = false;
+			}
+			return *this;
+		}
+		~MappedFile() {
+			Close();
+		}
+
+		explicit operator bool() const {
+			return is_open;
+		}
+
+		bool Open(const std::string& path) {
+			Close();
+#ifdef _WIN32
+			HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+				OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+			LARGE_INTEGER file_size;
+			if (!GetFileSizeEx(file, &file_size)) {
+				CloseHandle(file);
+				return false;
+			}
+			size = (size_t) file_size.QuadPart;
+			if (size > 0) {
+				HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (mapping != nullptr) {
+					data = (const char*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+					CloseHandle(mapping);
+				}
+			}
+			CloseHandle(file);
+#else
+			int fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0) {
+				return false;
+			}
+			struct stat info;
+			if (fstat(fd, &info) != 0) {
+				close(fd);
+				return false;
+			}
+			size = (size_t) info.st_size;
+			if (size > 0) {
+				void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+				data = mapping == MAP_FAILED ? nullptr : (const char*) mapping;
+			}
+			close(fd);
+#endif
+			if (size > 0 && data == nullptr) {
+				size = 0;
+				return false;
+			}
+			if (size == 0) {
+				data = "";
+			}
+			is_open = true;
+			return true;
+		}
+
+		void Close() {
+			if (is_open && size > 0) {
+#ifdef _WIN32
+				UnmapViewOfFile(data);
+#else
+				munmap((void*) data, size);
+#endif
+			}
+			data = nullptr;
+			size = 0;
+			is_open = false;
+		}
+
+	private:
+		bool is_open = false;
+	};
+}
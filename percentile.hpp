@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "compiledlogic.hpp"
+#include "rater.hpp"
+#include "threadpool.hpp"
+
+//Rates random placements of a seed's own items over its own checks, which keeps the start location, the randomized
+//pools and the shop and grub costs of the seed, to tell how hard the seed is compared to others with the same settings.
+//Only completability is checked, so a sample can be a placement the randomizer itself would never have produced
+namespace RandoRater {
+
+	//Draws for one sample before it is given up as uncompletable
+	const int kMaxPlacementAttempts = 100;
+
+	//splitmix64, seeded per sample so the distribution does not depend on the number of workers
+	struct PlacementRandom {
+		uint64_t state;
+
+		explicit PlacementRandom(uint64_t seed) : state(seed) {}
+
+		uint64_t Next() {
+			uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+
+		int Below(int n) {
+			return (int) (Next() % (uint64_t) n);
+		}
+	};
+
+	//Everything a sample is drawn from. Names are views into the log text or into the name buffers of the two parses
+	struct PlacementPool {
+		ParsedSpoilerLog progression; //what the rater reads from the log, and the settings
+		ParsedSpoilerLog listing; //only owns the names of the item listing
+		std::vector<Item> slots; //every check of the item listing, with its cost
+		std::vector<std::string_view> items; //item the log placed at each slot
+		std::vector<char> rated; //whether the rater reads items[i] at all, the others only take up a check
+		std::vector<Item> fixed; //checks that are not randomized with these settings
+		std::unordered_set<std::string> starting_items;
+	};
+
+	inline PlacementPool ParsePlacementPool(std::string_view spoiler_log) {
+		PlacementPool pool;
+		pool.progression = ParseSpoilerLog(spoiler_log);
+		if (pool.progression.settings.mode != RandoMode::kItem) {
+			throw std::logic_error("Random placements are only drawn for Item Randomizer seeds");
+		}
+		pool.listing.names.resize(spoiler_log.length());
+		std::unordered_set<std::string_view> rated_names;
+		for (auto& item : pool.progression.item_locations) {
+			rated_names.insert(item.name);
+		}
+
+		size_t listing_begin = spoiler_log.find("\nALL ITEMS");
+		std::string_view cur_area = "";
+		for (size_t line_begin = listing_begin == std::string_view::npos ? spoiler_log.length() : listing_begin + 1; line_begin < spoiler_log.length();) {
+			size_t line_end = spoiler_log.find('\n', line_begin);
+			if (line_end == std::string_view::npos) {
+				line_end = spoiler_log.length();
+			}
+			std::string_view line = spoiler_log.substr(line_begin, line_end - line_begin);
+			line_begin = line_end + 1;
+			if (!line.empty() && line.back() == '\r') {
+				line.remove_suffix(1);
+			}
+
+			if (line == "SETTINGS") {
+				break;
+			} else if (line.empty() || line == "ALL ITEMS") {
+				continue;
+			} else if (line.find(':') != std::string_view::npos) {
+				size_t area_begin = line[0] == '(' && line.find(") ") != std::string_view::npos ? line.find(") ") + 2 : 0;
+				cur_area = SpaceToUnderscore(line.substr(area_begin, line.length() - area_begin - 1), pool.listing);
+			} else if (line[0] == '(') {
+				pool.slots.push_back(ParseRegularItem(line, pool.listing));
+			} else {
+				size_t cost_begin = line.find('[');
+				if (cost_begin == std::string_view::npos || cost_begin == 0) {
+					throw std::logic_error("Bad line : " + std::string(line));
+				}
+				pool.slots.push_back(Item(SpaceToUnderscore(line.substr(0, cost_begin - 1), pool.listing), cur_area));
+			}
+		}
+		if (pool.slots.empty()) {
+			throw std::logic_error("Spoiler log has no item listing to draw placements from");
+		}
+		for (auto& slot : pool.slots) {
+			pool.items.push_back(slot.name);
+			pool.rated.push_back(rated_names.count(slot.name) > 0);
+		}
+
+		ParsedSpoilerLog defaults;
+		defaults.settings = pool.progression.settings;
+		AddDefaultItems(defaults);
+		pool.fixed.assign(defaults.item_locations.begin(), defaults.item_locations.end());
+		pool.starting_items.insert(pool.progression.settings.start_location);
+		return pool;
+	}
+
+	//Buffers of one worker, kept from sample to sample so drawing and rating a placement allocates nothing once they have grown
+	struct PlacementSample {
+		std::unique_ptr<RaterContext> context;
+		std::vector<int> order;
+		std::vector<Item> items;
+		std::vector<Placement> placements;
+		std::vector<SymbolId> starting_symbols;
+	};
+
+	//Shuffles the pool's items over its slots until the placement can be completed, raw is -1 if no draw could be
+	inline SeedRating RateRandomPlacement(const CompiledLogic& logic, const PlacementPool& pool, uint64_t seed, PlacementSample& sample,
+		const EvaluationOptions& options = EvaluationOptions()) {
+		PlacementRandom random(seed);
+		if (sample.context == nullptr) {
+			sample.context = std::make_unique<RaterContext>(logic);
+		}
+		sample.starting_symbols.clear();
+		for (auto& item : pool.starting_items) {
+			sample.starting_symbols.push_back(logic.symbols.Find(item));
+		}
+		SeedRating res;
+		for (int attempt = 0; attempt < kMaxPlacementAttempts && res.raw < 0; attempt++) {
+			sample.order.resize(pool.items.size());
+			for (int i = 0; i < (int) sample.order.size(); i++) {
+				sample.order[i] = i;
+			}
+			for (int i = (int) sample.order.size() - 1; i > 0; i--) {
+				std::swap(sample.order[i], sample.order[random.Below(i + 1)]);
+			}
+
+			sample.items.clear();
+			for (size_t s = 0; s < pool.slots.size(); s++) {
+				int item = sample.order[s];
+				if (pool.rated[item]) {
+					Item placed = pool.slots[s];
+					placed.name = pool.items[item];
+					sample.items.push_back(placed);
+				}
+			}
+			sample.items.insert(sample.items.end(), pool.fixed.begin(), pool.fixed.end());
+			sample.placements.clear();
+			for (auto& item : sample.items) {
+				sample.placements.push_back(MakePlacement(logic, item));
+			}
+			res = sample.context->RatePlacements(sample.placements, sample.starting_symbols, options);
+		}
+		return res;
+	}
+
+	struct PercentileResult {
+		std::vector<long long int> ratings; //raw ratings of the completable samples, sorted
+		int uncompletable = 0; //samples for which no completable placement was drawn
+	};
+
+	inline PercentileResult RatePlacementDistribution(const CompiledLogic& logic, const PlacementPool& pool, int sample_count,
+		uint64_t first_seed, int worker_count, const EvaluationOptions& options = EvaluationOptions()) {
+		std::vector<long long int> raw(std::max(0, sample_count), -1);
+		std::vector<PlacementSample> samples(std::max(1, std::min(worker_count, sample_count)));
+		ParallelFor(sample_count, worker_count, [&](int worker, int index) {
+			raw[index] = RateRandomPlacement(logic, pool, PlacementRandom(first_seed + index).Next(), samples[worker], options).raw;
+		});
+
+		PercentileResult res;
+		for (long long int rating : raw) {
+			if (rating < 0) {
+				res.uncompletable++;
+			} else {
+				res.ratings.push_back(rating);
+			}
+		}
+		std::sort(res.ratings.begin(), res.ratings.end());
+		return res;
+	}
+
+	//Share of the samples rated below raw, ties counting half
+	inline double RatingPercentile(const std::vector<long long int>& sorted_ratings, long long int raw) {
+		if (sorted_ratings.empty()) {
+			return 0;
+		}
+		size_t below = std::lower_bound(sorted_ratings.begin(), sorted_ratings.end(), raw) - sorted_ratings.begin();
+		size_t not_above = std::upper_bound(sorted_ratings.begin(), sorted_ratings.end(), raw) - sorted_ratings.begin();
+		return 100.0 * (below + (not_above - below) / 2.0) / sorted_ratings.size();
+	}
+}
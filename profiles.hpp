@@ -0,0 +1,461 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "compiledlogic.hpp"
+#include "loadoutmasks.hpp"
+#include "rater.hpp"
+
+//Rates a seed for several player profiles at once. A profile can refuse some of the skips the rater otherwise treats as
+//free (see ignored_macros) and can cap the difficulty of the loadouts it may use. Up to kProfileLanes profiles share one
+//pass over the seed: every rating is a vector with one lane per profile, so each loadout is summed once for all of them,
+//while every profile still takes its own checks in its own order
+namespace RandoRater {
+
+	const int kProfileLanes = 4;
+
+	struct RatingProfile {
+		std::string name;
+		int max_difficulty = kMaxDifficulty; //loadouts above this difficulty are out of logic
+		std::vector<std::string> refused; //ignored macros that are never available instead of free
+	};
+
+	//"name=item,item,..." where an item is a difficulty cap or -MACRO to refuse an ignored macro, e.g. "casual=2,-SPICYSKIPS"
+	inline RatingProfile ParseRatingProfile(std::string_view spec) {
+		RatingProfile profile;
+		size_t equals = spec.find('=');
+		profile.name = std::string(spec.substr(0, equals));
+		if (profile.name.empty()) {
+			throw std::logic_error("Profile without a name: " + std::string(spec));
+		}
+		std::string_view items = equals == std::string_view::npos ? std::string_view() : spec.substr(equals + 1);
+		while (!items.empty()) {
+			size_t comma = items.find(',');
+			std::string item(items.substr(0, comma));
+			items = comma == std::string_view::npos ? std::string_view() : items.substr(comma + 1);
+			if (item.empty()) {
+				continue;
+			} else if (item[0] == '-') {
+				if (ignored_macros.count(item.substr(1)) == 0) {
+					throw std::logic_error("Profile " + profile.name + " refuses " + item.substr(1) + ", which is not an ignored macro");
+				}
+				profile.refused.push_back(item.substr(1));
+			} else {
+				char* end;
+				long cap = strtol(item.c_str(), &end, 10);
+				if (*end != 0 || cap < 0 || cap > kMaxDifficulty) {
+					throw std::logic_error("Profile " + profile.name + " has a bad difficulty cap " + item);
+				}
+				profile.max_difficulty = (int) cap;
+			}
+		}
+		return profile;
+	}
+
+	//One rating per profile, kBigNumber if out of logic
+	struct alignas(32) LaneRatings {
+		long long int lane[kProfileLanes];
+	};
+
+	inline LaneRatings LaneBroadcast(long long int value) {
+		LaneRatings res;
+		for (int k = 0; k < kProfileLanes; k++) {
+			res.lane[k] = value;
+		}
+		return res;
+	}
+
+	//Sums stop at kBigNumber, so out of logic stays out of logic
+	inline LaneRatings LaneAdd(const LaneRatings& a, const LaneRatings& b) {
+		LaneRatings res;
+#if defined(__AVX2__)
+		__m256i sum = _mm256_add_epi64(_mm256_load_si256((const __m256i*) a.lane), _mm256_load_si256((const __m256i*) b.lane));
+		__m256i big = _mm256_set1_epi64x(kBigNumber);
+		_mm256_store_si256((__m256i*) res.lane, _mm256_blendv_epi8(sum, big, _mm256_cmpgt_epi64(sum, big)));
+#else
+		for (int k = 0; k < kProfileLanes; k++) {
+			res.lane[k] = std::min(a.lane[k] + b.lane[k], kBigNumber);
+		}
+#endif
+		return res;
+	}
+
+	inline LaneRatings LaneMin(const LaneRatings& a, const LaneRatings& b) {
+		LaneRatings res;
+#if defined(__AVX2__)
+		__m256i left = _mm256_load_si256((const __m256i*) a.lane), right = _mm256_load_si256((const __m256i*) b.lane);
+		_mm256_store_si256((__m256i*) res.lane, _mm256_blendv_epi8(left, right, _mm256_cmpgt_epi64(left, right)));
+#else
+		for (int k = 0; k < kProfileLanes; k++) {
+			res.lane[k] = std::min(a.lane[k], b.lane[k]);
+		}
+#endif
+		return res;
+	}
+
+	inline LaneRatings LaneMax(const LaneRatings& a, const LaneRatings& b) {
+		LaneRatings res;
+#if defined(__AVX2__)
+		__m256i left = _mm256_load_si256((const __m256i*) a.lane), right = _mm256_load_si256((const __m256i*) b.lane);
+		_mm256_store_si256((__m256i*) res.lane, _mm256_blendv_epi8(right, left, _mm256_cmpgt_epi64(left, right)));
+#else
+		for (int k = 0; k < kProfileLanes; k++) {
+			res.lane[k] = std::max(a.lane[k], b.lane[k]);
+		}
+#endif
+		return res;
+	}
+
+	//The progression of RaterContext with macros solved as in EvaluationMode::kFixpoint, run for every lane in lockstep.
+	//A lane with the default profile rates exactly like the fixpoint evaluator. Buffers are kept from seed to seed
+	class ProfileRater {
+	public:
+		ProfileRater(const CompiledLogic& logic, const std::vector<RatingProfile>& profiles) : logic(logic), lane_count((int) profiles.size()),
+			base(logic.symbols.size(), LaneBroadcast(kBigNumber)), current(logic.symbols.size()), acquired(logic.symbols.size()),
+			base_blocked(logic.symbols.size()), blocked(logic.symbols.size()), stale((logic.component_begin.size() + 63) / 64),
+			placements_at(logic.locations.size()), queued(logic.macro_count), radiance(FindLocation(logic, "Radiance")) {
+			if (lane_count < 1 || lane_count > kProfileLanes) {
+				throw std::logic_error("A profile rater takes 1 to " + std::to_string(kProfileLanes) + " profiles");
+			}
+			for (SymbolId symbol = 0; symbol < logic.symbols.size(); symbol++) {
+				if (logic.ignored[symbol]) {
+					base[symbol] = LaneBroadcast(0);
+				}
+			}
+			for (int d = 0; d <= kMaxDifficulty; d++) {
+				floors[d] = LaneBroadcast(kBigNumber); //unused lanes never reach anything
+			}
+			for (int k = 0; k < lane_count; k++) {
+				for (auto& name : profiles[k].refused) {
+					SymbolId symbol = logic.symbols.Find(name);
+					if (symbol != kNoSymbol) {
+						base[symbol].lane[k] = kBigNumber;
+					}
+				}
+				for (int d = 0; d <= profiles[k].max_difficulty; d++) {
+					floors[d].lane[k] = kTensTable[d];
+				}
+			}
+			for (SymbolId symbol = 0; symbol < logic.symbols.size(); symbol++) {
+				for (int k = 0; k < kProfileLanes; k++) {
+					if (base[symbol].lane[k] >= kBigNumber) {
+						base_blocked[symbol] |= 1u << k;
+					}
+				}
+			}
+		}
+
+		ProfileRater(const ProfileRater&) = delete;
+		ProfileRater& operator=(const ProfileRater&) = delete;
+
+		//One rating per profile, in the order they were given
+		std::vector<SeedRating> Rate(const std::vector<Placement>& placements, const std::vector<SymbolId>& starting_symbols) {
+			RANDORATER_PHASE(kPhaseRateProgression);
+			Reset(placements);
+			for (SymbolId symbol : starting_symbols) {
+				if (symbol != kNoSymbol) {
+					for (int k = 0; k < lane_count; k++) {
+						Acquire(symbol, k, 0);
+					}
+				}
+			}
+			SolveMacros();
+
+			std::vector<SeedRating> res(lane_count);
+			unsigned int active = (1u << lane_count) - 1;
+			while (active != 0) {
+				RANDORATER_COUNT(kProgressionSteps);
+				EvaluateDirty(placements, active);
+				for (int k = 0; k < lane_count; k++) {
+					if (active & (1u << k)) {
+						int next_check = NextCheck(k);
+						if (next_check < 0) { //nothing left in logic, so the seed cannot be completed with this profile
+							active &= ~(1u << k);
+						} else {
+							Take(placements, next_check, k);
+							res[k].checks_taken++;
+						}
+					}
+				}
+				SolveMacros();
+
+				LaneRatings radiance_rating = EvaluateLocation(radiance);
+				for (int k = 0; k < lane_count; k++) {
+					if ((active & (1u << k)) && radiance_rating.lane[k] < kBigNumber) {
+						res[k].raw = radiance_rating.lane[k];
+						active &= ~(1u << k);
+					} else if (res[k].checks_taken == (int) placements.size()) {
+						active &= ~(1u << k);
+					}
+				}
+			}
+			return res;
+		}
+
+	private:
+		const CompiledLogic& logic;
+		int lane_count;
+		std::vector<LaneRatings> base; //per symbol before anything is acquired, 0 for ignored macros the profile does not refuse
+		LaneRatings floors[kMaxDifficulty + 1]; //lowest rating of a loadout per difficulty, kBigNumber above the profile's cap
+		std::vector<LaneRatings> current; //acquired rating, or the value of a macro while its component is solved
+		std::vector<unsigned char> acquired; //per symbol, bit k for lane k
+		std::vector<unsigned char> base_blocked, blocked; //per symbol, lanes where current is kBigNumber
+		std::vector<uint64_t> stale; //components that may make a macro reachable since they were last solved
+		std::vector<std::vector<int>> placements_at;
+		std::vector<LaneRatings> ratings; //per placement
+		std::vector<unsigned char> checked, eligible; //per placement, bit k for lane k
+		std::vector<uint64_t> dirty; //placements to evaluate again, in any lane
+		std::vector<std::pair<long long int, int>> reachable[kProfileLanes]; //min-heaps of (rating, placement)
+		std::vector<std::pair<int, int>> grub_gated, essence_gated; //(cost, placement) sorted by cost
+		int grub_count[kProfileLanes], essence_count[kProfileLanes];
+		size_t grubs_unlocked[kProfileLanes], essence_unlocked[kProfileLanes];
+		std::vector<int> worklist;
+		std::vector<char> queued;
+		SymbolId radiance;
+
+		void Reset(const std::vector<Placement>& placements) {
+			current = base;
+			std::fill(acquired.begin(), acquired.end(), 0);
+			blocked = base_blocked;
+			std::fill(stale.begin(), stale.end(), ~0ull);
+			for (auto& at : placements_at) {
+				at.clear();
+			}
+			size_t count = placements.size();
+			unsigned char all_lanes = (unsigned char) ((1u << lane_count) - 1);
+			ratings.assign(count, LaneBroadcast(kBigNumber));
+			checked.assign(count, 0);
+			eligible.assign(count, all_lanes);
+			dirty.assign((count + 63) / 64, 0);
+			grub_gated.clear();
+			essence_gated.clear();
+			for (int k = 0; k < kProfileLanes; k++) {
+				reachable[k].clear();
+				grub_count[k] = essence_count[k] = 0;
+				grubs_unlocked[k] = essence_unlocked[k] = 0;
+			}
+			for (int p = 0; p < (int) count; p++) {
+				const Item& item = *placements[p].source;
+				if (placements[p].location != kNoSymbol) {
+					placements_at[placements[p].location].push_back(p);
+				}
+				if (item.cost_type == ItemCost::kGrub && item.cost > 0) {
+					grub_gated.push_back(std::make_pair(item.cost, p));
+					eligible[p] = 0;
+				} else if (item.cost_type == ItemCost::kEssence && item.cost > 0) {
+					essence_gated.push_back(std::make_pair(item.cost, p));
+					eligible[p] = 0;
+				}
+				SetMaskBit(dirty.data(), p);
+			}
+			std::sort(grub_gated.begin(), grub_gated.end());
+			std::sort(essence_gated.begin(), essence_gated.end());
+		}
+
+		void Acquire(SymbolId symbol, int lane, long long int rating) {
+			current[symbol].lane[lane] = rating;
+			acquired[symbol] |= 1u << lane;
+			blocked[symbol] &= ~(1u << lane);
+			for (const int* m = logic.macro_dependents.First(symbol); m != logic.macro_dependents.Last(symbol); m++) {
+				SetMaskBit(stale.data(), logic.macro_component[*m]);
+			}
+			for (const int* l = logic.location_dependents.First(symbol); l != logic.location_dependents.Last(symbol); l++) {
+				for (int placement : placements_at[*l]) {
+					SetMaskBit(dirty.data(), placement);
+				}
+			}
+		}
+
+		//Stops at the first symbol that leaves every lane blocked, most loadouts are out of logic in all of them
+		LaneRatings LoadoutRating(const LoadoutTable& table, int loadout) const {
+			LaneRatings rating = LaneBroadcast(0);
+			unsigned int lanes_blocked = 0, all_lanes = (1u << lane_count) - 1;
+			for (int s = table.loadout_begin[loadout]; s < table.loadout_begin[loadout + 1]; s++) {
+				lanes_blocked |= blocked[table.symbols[s]];
+				if ((lanes_blocked & all_lanes) == all_lanes) {
+					return LaneBroadcast(kBigNumber);
+				}
+				rating = LaneAdd(rating, current[table.symbols[s]]);
+			}
+			return LaneMax(rating, floors[table.difficulties[loadout]]);
+		}
+
+		LaneRatings EvaluateLocation(SymbolId location) const {
+			RANDORATER_COUNT(kLocationEvaluations);
+			const LoadoutTable& table = logic.location_logic;
+			LaneRatings rating = LaneBroadcast(kBigNumber);
+			for (int l = table.entry_begin[location]; l < table.entry_begin[location + 1]; l++) {
+				RANDORATER_COUNT(kLoadoutsExamined);
+				rating = LaneMin(rating, LoadoutRating(table, l));
+			}
+			return rating;
+		}
+
+		//SolveMacros over every lane at once. Lanes a macro is already acquired in keep their rating. Only components that
+		//mention a symbol acquired since they were last solved are solved again, the others would stay out of logic
+		void SolveMacros() {
+			const LoadoutTable& table = logic.macro_logic;
+			unsigned char all_lanes = (unsigned char) ((1u << lane_count) - 1);
+			for (int c = 0; c + 1 < logic.component_begin.size(); c++) {
+				if (!(stale[c / 64] & (1ull << (c % 64)))) {
+					continue;
+				}
+				stale[c / 64] &= ~(1ull << (c % 64));
+				for (int i = logic.component_begin[c]; i < logic.component_begin[c + 1]; i++) {
+					SymbolId macro = logic.macro_order[i];
+					if (acquired[macro] != all_lanes && !logic.ignored[macro]) {
+						for (int k = 0; k < lane_count; k++) {
+							if (!(acquired[macro] & (1u << k))) {
+								current[macro].lane[k] = kBigNumber;
+							}
+						}
+						blocked[macro] = (unsigned char) (all_lanes & ~acquired[macro]);
+						worklist.push_back(macro);
+						queued[macro] = 1;
+					}
+				}
+				while (!worklist.empty()) {
+					SymbolId macro = worklist.back();
+					worklist.pop_back();
+					queued[macro] = 0;
+					RANDORATER_COUNT(kMacroEvaluations);
+					LaneRatings rating = LaneBroadcast(kBigNumber);
+					for (int l = table.entry_begin[macro]; l < table.entry_begin[macro + 1]; l++) {
+						RANDORATER_COUNT(kLoadoutsExamined);
+						rating = LaneMin(rating, LoadoutRating(table, l));
+					}
+					bool lowered = false;
+					for (int k = 0; k < lane_count; k++) {
+						if (!(acquired[macro] & (1u << k)) && rating.lane[k] < current[macro].lane[k]) {
+							current[macro].lane[k] = rating.lane[k];
+							blocked[macro] &= ~(1u << k);
+							lowered = true;
+						}
+					}
+					if (lowered) {
+						for (const int* m = logic.macro_dependents.First(macro); m != logic.macro_dependents.Last(macro); m++) {
+							if (logic.macro_component[*m] == c && acquired[*m] != all_lanes && !logic.ignored[*m] && !queued[*m]) {
+								worklist.push_back(*m);
+								queued[*m] = 1;
+							}
+						}
+					}
+				}
+				for (int i = logic.component_begin[c]; i < logic.component_begin[c + 1]; i++) {
+					SymbolId macro = logic.macro_order[i];
+					if (logic.ignored[macro]) {
+						continue;
+					}
+					for (int k = 0; k < lane_count; k++) {
+						if (!(acquired[macro] & (1u << k)) && current[macro].lane[k] < kBigNumber) {
+							Acquire(macro, k, current[macro].lane[k]);
+						}
+					}
+				}
+			}
+		}
+
+		void EvaluateDirty(const std::vector<Placement>& placements, unsigned int active) {
+			for (size_t word = 0; word < dirty.size(); word++) {
+				for (uint64_t bits = dirty[word]; bits != 0; bits &= bits - 1) {
+					int p = (int) (word * 64 + CountTrailingZeros(bits));
+					unsigned int lanes = active & eligible[p] & ~checked[p];
+					if (lanes == 0) {
+						continue;
+					}
+					const Placement& placement = placements[p];
+					LaneRatings rating = EvaluateLocation(placement.location == kNoSymbol ? FindLocation(logic, placement.source->location) : placement.location);
+					for (int k = 0; k < lane_count; k++) {
+						if (lanes & (1u << k)) {
+							ratings[p].lane[k] = rating.lane[k];
+							if (rating.lane[k] < kBigNumber) {
+								reachable[k].push_back(std::make_pair(rating.lane[k], p));
+								std::push_heap(reachable[k].begin(), reachable[k].end(), std::greater<std::pair<long long int, int>>());
+							}
+						}
+					}
+				}
+				dirty[word] = 0;
+			}
+		}
+
+		int NextCheck(int lane) {
+			auto& heap = reachable[lane];
+			while (!heap.empty()) {
+				auto next = heap.front();
+				if (!(checked[next.second] & (1u << lane)) && ratings[next.second].lane[lane] == next.first) {
+					return next.second;
+				}
+				std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<long long int, int>>());
+				heap.pop_back();
+			}
+			return -1;
+		}
+
+		void Unlock(const std::vector<std::pair<int, int>>& gated, size_t& unlocked, int count, int lane) {
+			for (; unlocked < gated.size() && gated[unlocked].first <= count; unlocked++) {
+				eligible[gated[unlocked].second] |= 1u << lane;
+				SetMaskBit(dirty.data(), gated[unlocked].second);
+			}
+		}
+
+		void Take(const std::vector<Placement>& placements, int check, int lane) {
+			const Placement& placement = placements[check];
+			SymbolId item = placement.item;
+			if (placement.grub) {
+				Unlock(grub_gated, grubs_unlocked[lane], ++grub_count[lane], lane);
+			}
+			if (placement.essence > 0) {
+				essence_count[lane] += placement.essence;
+				Unlock(essence_gated, essence_unlocked[lane], essence_count[lane], lane);
+			}
+			if (placement.chain >= 0) {
+				item = kNoSymbol;
+				for (int l = logic.chain_begin[placement.chain]; l < logic.chain_begin[placement.chain + 1]; l++) {
+					if (!(acquired[logic.chain_levels[l]] & (1u << lane))) {
+						item = logic.chain_levels[l];
+						break;
+					}
+				}
+			}
+			checked[check] |= 1u << lane;
+			if (item != kNoSymbol && !(acquired[item] & (1u << lane))) {
+				Acquire(item, lane, ratings[check].lane[lane]);
+			}
+		}
+	};
+
+	//Every profile's rating of an item randomizer seed, in groups of kProfileLanes
+	inline std::vector<SeedRating> RateSeedProfiles(std::string_view spoiler_log, const CompiledLogic& logic, const std::vector<RatingProfile>& profiles) {
+		ParsedSpoilerLog parsed;
+		{
+			RANDORATER_PHASE(kPhaseParseLog);
+			ParseSpoilerLog(spoiler_log, parsed);
+			if (parsed.settings.mode != RandoMode::kItem) {
+				throw std::logic_error("Profiles are only rated for Item Randomizer seeds");
+			}
+			AddDefaultItems(parsed);
+		}
+		std::vector<Placement> placements;
+		for (auto& item : parsed.item_locations) { //iteration order of item_locations decides ties, so it is kept
+			placements.push_back(MakePlacement(logic, item));
+		}
+		std::vector<SymbolId> starting_symbols { logic.symbols.Find(parsed.settings.start_location) };
+
+		std::vector<SeedRating> res;
+		for (size_t first = 0; first < profiles.size(); first += kProfileLanes) {
+			std::vector<RatingProfile> group(profiles.begin() + first, profiles.begin() + std::min(profiles.size(), first + kProfileLanes));
+			ProfileRater rater(logic, group);
+			std::vector<SeedRating> ratings = rater.Rate(placements, starting_symbols);
+			res.insert(res.end(), ratings.begin(), ratings.end());
+		}
+		return res;
+	}
+}
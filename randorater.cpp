@@ -0,0 +1,244 @@
+#include <cstring>
+#include <exception>
+#include <ios>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#define RANDORATER_BUILDING
+#include "randorater.h"
+#include "compiledlogic.hpp"
+#include "logiccache.hpp"
+#include "rater.hpp"
+
+//librandorater: the C interface of randorater.h over RaterContext. Exceptions stop at this file
+struct rr_logic {
+	RandoRater::CompiledLogic logic;
+	std::unique_ptr<RandoRater::TransitionLogicCache> transitions; //area and room logic, read from the same directory
+};
+
+struct rr_rater {
+	explicit rr_rater(const rr_logic& logic) : context(logic.logic, logic.transitions.get()) {}
+
+	RandoRater::RaterContext context;
+	std::string log; //the parsed log points into it
+	bool parsed = false;
+	std::string error;
+};
+
+namespace RandoRater {
+
+	//Status of the exception being handled, with its message in error. logic_status is what a logic_error means here
+	rr_status CurrentExceptionStatus(rr_status logic_status, std::string& error) {
+		try {
+			throw;
+		} catch (const std::bad_alloc&) {
+			error = "Out of memory";
+			return RR_ERROR_MEMORY;
+		} catch (const std::ios_base::failure& e) {
+			error = e.what();
+			return RR_ERROR_IO;
+		} catch (const std::logic_error& e) {
+			error = e.what();
+			return logic_status;
+		} catch (const std::exception& e) {
+			error = e.what();
+			return RR_ERROR_INTERNAL;
+		} catch (...) {
+			error = "Unknown error";
+			return RR_ERROR_INTERNAL;
+		}
+	}
+
+	void CopyError(const std::string& message, char* error, size_t error_size) {
+		if (error != nullptr && error_size > 0) {
+			size_t length = std::min(message.length(), error_size - 1);
+			memcpy(error, message.data(), length);
+			error[length] = 0;
+		}
+	}
+
+	rr_status Fail(rr_rater* rater, rr_status status, const char* message) {
+		rater->error = message;
+		return status;
+	}
+}
+
+using namespace RandoRater;
+
+extern "C" {
+
+	int rr_abi_version(void) {
+		return RANDORATER_ABI_VERSION;
+	}
+
+	const char* rr_status_name(rr_status status) {
+		switch (status) {
+		case RR_OK: return "ok";
+		case RR_ERROR_ARGUMENT: return "bad argument";
+		case RR_ERROR_IO: return "unreadable logic file";
+		case RR_ERROR_LOGIC: return "bad logic";
+		case RR_ERROR_LOG: return "bad spoiler log";
+		case RR_ERROR_NO_LOG: return "no spoiler log parsed";
+		case RR_ERROR_MEMORY: return "out of memory";
+		case RR_ERROR_INTERNAL: return "internal error";
+		}
+		return "unknown status";
+	}
+
+	void rr_logic_options_init(rr_logic_options* options) {
+		if (options != nullptr) {
+			options->xml_directory = nullptr;
+			options->ignore_bad_difficulty = 0;
+			options->use_cache = 1;
+		}
+	}
+
+	rr_status rr_logic_load(const rr_logic_options* options, rr_logic** logic, char* error, size_t error_size) {
+		if (logic == nullptr) {
+			CopyError("No logic handle to load into", error, error_size);
+			return RR_ERROR_ARGUMENT;
+		}
+		*logic = nullptr;
+		rr_logic_options defaults;
+		rr_logic_options_init(&defaults);
+		const rr_logic_options& settings = options != nullptr ? *options : defaults;
+		std::string message;
+		try {
+			std::string xml_directory = settings.xml_directory != nullptr ? settings.xml_directory : kXmlDirectory;
+			auto loaded = std::make_unique<rr_logic>();
+#if defined(RANDORATER_EMBEDDED_LOGIC)
+			if (settings.xml_directory == nullptr && (settings.ignore_bad_difficulty != 0) == kEmbeddedIgnoreBadDifficulty) {
+				loaded->logic = EmbeddedLogic();
+			} else
+#endif
+			{
+				loaded->logic = LoadLogic(XmlPathIn(xml_directory, kParsedLogicPath),
+					settings.use_cache ? XmlPathIn(xml_directory, kCompiledLogicPath) : std::string(),
+					DefaultCompileOptions(settings.ignore_bad_difficulty != 0, xml_directory), false);
+			}
+			loaded->transitions = std::make_unique<TransitionLogicCache>(xml_directory);
+			FindLocation(loaded->logic, "Radiance"); //every rater needs it
+			*logic = loaded.release();
+			CopyError("", error, error_size);
+			return RR_OK;
+		} catch (...) {
+			rr_status status = CurrentExceptionStatus(RR_ERROR_LOGIC, message);
+			CopyError(message, error, error_size);
+			return status;
+		}
+	}
+
+	void rr_logic_free(rr_logic* logic) {
+		delete logic;
+	}
+
+	rr_status rr_rater_create(const rr_logic* logic, rr_rater** rater) {
+		if (logic == nullptr || rater == nullptr) {
+			return RR_ERROR_ARGUMENT;
+		}
+		*rater = nullptr;
+		try {
+			*rater = new rr_rater(*logic);
+			return RR_OK;
+		} catch (const std::bad_alloc&) {
+			return RR_ERROR_MEMORY;
+		} catch (...) {
+			return RR_ERROR_INTERNAL;
+		}
+	}
+
+	void rr_rater_free(rr_rater* rater) {
+		delete rater;
+	}
+
+	rr_status rr_parse_log(rr_rater* rater, const char* data, size_t length) {
+		if (rater == nullptr) {
+			return RR_ERROR_ARGUMENT;
+		} else if (data == nullptr && length > 0) {
+			return Fail(rater, RR_ERROR_ARGUMENT, "No spoiler log given");
+		}
+		rater->parsed = false;
+		try {
+			rater->log.assign(data, length);
+			rater->context.ParseSeed(rater->log);
+			rater->parsed = true;
+			rater->error.clear();
+			return RR_OK;
+		} catch (...) {
+			return CurrentExceptionStatus(RR_ERROR_LOG, rater->error);
+		}
+	}
+
+	rr_status rr_parsed_mode(rr_rater* rater, rr_rando_mode* mode) {
+		if (rater == nullptr) {
+			return RR_ERROR_ARGUMENT;
+		} else if (mode == nullptr) {
+			return Fail(rater, RR_ERROR_ARGUMENT, "No mode to write into");
+		} else if (!rater->parsed) {
+			return Fail(rater, RR_ERROR_NO_LOG, "No spoiler log parsed");
+		}
+		RandoMode parsed_mode = rater->context.Parsed().settings.mode;
+		*mode = parsed_mode == RandoMode::kArea ? RR_MODE_AREA : parsed_mode == RandoMode::kRoom ? RR_MODE_ROOM : RR_MODE_ITEM;
+		rater->error.clear();
+		return RR_OK;
+	}
+
+	rr_status rr_parsed_placement_count(rr_rater* rater, size_t* count) {
+		if (rater == nullptr) {
+			return RR_ERROR_ARGUMENT;
+		} else if (count == nullptr) {
+			return Fail(rater, RR_ERROR_ARGUMENT, "No count to write into");
+		} else if (!rater->parsed) {
+			return Fail(rater, RR_ERROR_NO_LOG, "No spoiler log parsed");
+		}
+		*count = rater->context.Placements().size();
+		rater->error.clear();
+		return RR_OK;
+	}
+
+	rr_status rr_rate(rr_rater* rater, const rr_rate_options* options, rr_result* result) {
+		if (rater == nullptr) {
+			return RR_ERROR_ARGUMENT;
+		} else if (result == nullptr) {
+			return Fail(rater, RR_ERROR_ARGUMENT, "No result to rate into");
+		} else if (!rater->parsed) {
+			return Fail(rater, RR_ERROR_NO_LOG, "No spoiler log parsed");
+		}
+		EvaluationOptions evaluation_options;
+		switch (options != nullptr ? options->eval_mode : RR_EVAL_FIXPOINT) {
+		case RR_EVAL_FIXPOINT:
+			evaluation_options.mode = EvaluationMode::kFixpoint;
+			break;
+		case RR_EVAL_RECURSIVE:
+			evaluation_options.mode = EvaluationMode::kRecursive;
+			break;
+		case RR_EVAL_BITSET:
+			evaluation_options.mode = EvaluationMode::kBitset;
+			break;
+		default:
+			return Fail(rater, RR_ERROR_ARGUMENT, "Unknown evaluation mode");
+		}
+		try {
+			SeedRating rating = rater->context.RateParsed(evaluation_options);
+			result->raw_rating = rating.raw;
+			result->completable = rating.raw >= 0;
+			result->log10_rating = rating.raw >= 0 ? Log10Rating(rating.raw) : 0;
+			result->checks_taken = rating.checks_taken;
+			rater->error.clear();
+			return RR_OK;
+		} catch (...) {
+			return CurrentExceptionStatus(RR_ERROR_LOG, rater->error);
+		}
+	}
+
+	rr_status rr_rate_log(rr_rater* rater, const char* data, size_t length, const rr_rate_options* options, rr_result* result) {
+		rr_status status = rr_parse_log(rater, data, length);
+		return status == RR_OK ? rr_rate(rater, options, result) : status;
+	}
+
+	const char* rr_rater_error(const rr_rater* rater) {
+		return rater != nullptr ? rater->error.c_str() : "No rater";
+	}
+}
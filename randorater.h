@@ -0,0 +1,98 @@
+#ifndef RANDORATER_H
+#define RANDORATER_H
+
+/*C interface of librandorater, built from randorater.cpp. Nothing is global: a logic handle is read only once loaded and
+  can be shared by any number of threads, a rater belongs to one thread at a time and keeps its buffers between seeds.
+  No function throws or exits, every failure is returned as a status with a message*/
+
+#include <stddef.h>
+
+#if defined(_WIN32) && defined(RANDORATER_SHARED)
+#if defined(RANDORATER_BUILDING)
+#define RANDORATER_API __declspec(dllexport)
+#else
+#define RANDORATER_API __declspec(dllimport)
+#endif
+#elif defined(__GNUC__)
+#define RANDORATER_API __attribute__((visibility("default")))
+#else
+#define RANDORATER_API
+#endif
+
+#define RANDORATER_ABI_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum rr_status {
+	RR_OK = 0,
+	RR_ERROR_ARGUMENT, /*null handle or out pointer, or an unknown option*/
+	RR_ERROR_IO, /*a logic file is missing or unreadable*/
+	RR_ERROR_LOGIC, /*the logic files are inconsistent, e.g. a difficulty out of range*/
+	RR_ERROR_LOG, /*the spoiler log is malformed or names a check or transition the logic does not know*/
+	RR_ERROR_NO_LOG, /*rr_rate before a log was parsed successfully*/
+	RR_ERROR_MEMORY,
+	RR_ERROR_INTERNAL
+} rr_status;
+
+typedef enum rr_eval_mode {
+	RR_EVAL_FIXPOINT = 0, /*--eval fixpoint*/
+	RR_EVAL_RECURSIVE,
+	RR_EVAL_BITSET
+} rr_eval_mode;
+
+typedef enum rr_rando_mode {
+	RR_MODE_ITEM = 0,
+	RR_MODE_AREA,
+	RR_MODE_ROOM
+} rr_rando_mode;
+
+typedef struct rr_logic rr_logic;
+typedef struct rr_rater rr_rater;
+
+typedef struct rr_logic_options {
+	const char* xml_directory; /*directory of parsed.xml and the randomizer XML, NULL for XML in the working directory*/
+	int ignore_bad_difficulty; /*treat loadouts with a difficulty of -1 as 0 instead of failing*/
+	int use_cache; /*map parsed.bin when it is up to date instead of compiling parsed.xml, never written by the library*/
+} rr_logic_options;
+
+typedef struct rr_rate_options {
+	rr_eval_mode eval_mode;
+} rr_rate_options;
+
+typedef struct rr_result {
+	long long raw_rating; /*-1 if the seed cannot be completed*/
+	double log10_rating; /*0 if the seed cannot be completed*/
+	int completable;
+	int checks_taken;
+} rr_result;
+
+RANDORATER_API int rr_abi_version(void);
+RANDORATER_API const char* rr_status_name(rr_status status);
+
+RANDORATER_API void rr_logic_options_init(rr_logic_options* options);
+/*On failure *logic is set to NULL and the message is written to error (truncated to error_size, which can be 0)*/
+RANDORATER_API rr_status rr_logic_load(const rr_logic_options* options, rr_logic** logic, char* error, size_t error_size);
+RANDORATER_API void rr_logic_free(rr_logic* logic);
+
+/*The logic has to outlive the rater*/
+RANDORATER_API rr_status rr_rater_create(const rr_logic* logic, rr_rater** rater);
+RANDORATER_API void rr_rater_free(rr_rater* rater);
+
+/*Copies the log, so data can be freed as soon as this returns*/
+RANDORATER_API rr_status rr_parse_log(rr_rater* rater, const char* data, size_t length);
+RANDORATER_API rr_status rr_parsed_mode(rr_rater* rater, rr_rando_mode* mode);
+RANDORATER_API rr_status rr_parsed_placement_count(rr_rater* rater, size_t* count);
+/*Rates the log last parsed, options can be NULL for the defaults*/
+RANDORATER_API rr_status rr_rate(rr_rater* rater, const rr_rate_options* options, rr_result* result);
+/*rr_parse_log followed by rr_rate*/
+RANDORATER_API rr_status rr_rate_log(rr_rater* rater, const char* data, size_t length, const rr_rate_options* options, rr_result* result);
+/*Message of the rater's last failed call, "" if the last call succeeded. Valid until the next call on the rater*/
+RANDORATER_API const char* rr_rater_error(const rr_rater* rater);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1188 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <memory>
+#include <unordered_set>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <set>
+#include <string_view>
+#include <iterator>
+
+#include "arena.hpp"
+#include "compiledlogic.hpp"
+#include "itemcatalog.hpp"
+#include "mappedfile.hpp"
+#include "stats.hpp"
+#include "logictables.hpp"
+#include "transitions.hpp"
+#if defined(RANDORATER_EMBEDDED_LOGIC)
+#include "embeddedlogic.hpp"
+#endif
+
+namespace RandoRater {
+
+	const long long int kBigNumber = 1000000000000;
+	const bool DEBUG = false;
+
+	const long long int kTensTable[11] = {
+		0,
+		10,
+		100,
+		1000,
+		10000,
+		100000,
+		1000000,
+		10000000,
+		100000000,
+		1000000000,
+		10000000000
+	};
+
+	enum class ItemCost { //Simple keys as cost are defined as macros
+		kGrub, kEssence, kOther
+	};
+	struct Item {
+		std::string_view name;
+		std::string_view location;
+		ItemCost cost_type;
+		int cost;
+		Item() : name(""), location(""), cost_type(ItemCost::kOther), cost(0) {}
+		Item(std::string_view vanilla_item) : name(vanilla_item), location(vanilla_item), cost_type(ItemCost::kOther), cost(0) {}
+		Item(std::string_view name, std::string_view location) : name(name), location(location), cost_type(ItemCost::kOther), cost(0) {}
+		bool operator==(const Item& other) const {
+			return name == other.name && location == other.location;
+		}
+	};
+	struct ItemHasher {
+		std::size_t operator()(const Item& item) const {
+			return std::hash<std::string_view>()(item.name);
+		}
+	};
+	//Iteration order decides ties between equally easy checks, and only depends on the insertion order and the hash, not
+	//on where the nodes are allocated
+	typedef std::unordered_set<Item, ItemHasher, std::equal_to<Item>, ArenaAllocator<Item>> ItemSet;
+	struct RandoSettings {
+		RandoMode mode = RandoMode::kItem;
+		std::string start_location;
+		std::string start_name; //as written in the log, transition modes start at its door instead of its waypoint
+		bool randomized_grubs = false, randomized_roots = false;
+	};
+	inline std::unordered_map<std::string_view, std::string> start_location_lookup {
+		std::make_pair("King's Pass", "King's_Pass"),
+		std::make_pair("Stag Nest", "Stag_Nest"),
+		std::make_pair("West Crossroads", "Crossroads"),
+		std::make_pair("East Crossroads", "Crossroads"),
+		std::make_pair("Ancestral Mound", "Ancestral_Mound"),
+		std::make_pair("West Fog Canyon", "Left_Fog_Canyon"),
+		std::make_pair("East Fog Canyon", "Right_Fog_Canyon"),
+		std::make_pair("Queen's Station", "Queen's_Station"),
+		std::make_pair("Fungal Wastes", "Fungal_Wastes"),
+		std::make_pair("Fungal Core", "Fungal_Core"),
+		std::make_pair("Distant Village", "Distant_Village"),
+		std::make_pair("Abyss", "Abyss"),
+		std::make_pair("Hive", "Hive"),
+		std::make_pair("Kingdom's Edge", "Central_Kingdom's_Edge"),
+		std::make_pair("Hallownest's Crown", "Hallownest's_Crown"),
+		std::make_pair("Crystallized Mound", "Crystallized_Mound"),
+		std::make_pair("Royal Waterways", "Upper_Left_Waterways"),
+		std::make_pair("Queen's Gardens", "Top_Left_Queen's_Gardens"),
+		std::make_pair("Far Greenpath", "Greenpath"),
+		std::make_pair("Greenpath", "Greenpath"),
+		std::make_pair("City Storerooms", "Left_Elevator"),
+		std::make_pair("King's Station", "Upper_King's_Station"),
+		std::make_pair("Outside Colosseum", "Top_Kingdom's_Edge"),
+		std::make_pair("City of Tears", "Left_City")
+	};
+
+	inline std::string DefaultSpoilerLogPath() {
+		const char* path_stem = getenv("USERPROFILE");
+		if (path_stem == nullptr) {
+			throw std::ios_base::failure("USERPROFILE is not set");
+		}
+		return std::string(path_stem) + "\\AppData\\LocalLow\\Team Cherry\\Hollow Knight\\RandomizerSpoilerLog.txt";
+	}
+
+	//Spoiler log contents, mapped from the file or read from stdin if the path is "-"
+	struct SpoilerLogText {
+		MappedFile file;
+		std::string buffer;
+		std::string_view text;
+	};
+
+	inline std::unique_ptr<SpoilerLogText> ReadSpoilerLog(const std::string& path) {
+		RANDORATER_PHASE(kPhaseReadLog);
+		auto res = std::make_unique<SpoilerLogText>();
+		if (path == "-") {
+			res->buffer.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+			res->text = res->buffer;
+		} else if (res->file.Open(path)) {
+			res->text = std::string_view(res->file.data, res->file.size);
+		} else {
+			throw std::ios_base::failure("Unable to open " + path);
+		}
+		return res;
+	}
+
+	//Everything the rater needs from a spoiler log. Names are views into the log text, or into names if spaces had to be
+	//replaced by underscores, so the text has to outlive it
+	struct ParsedSpoilerLog {
+		std::vector<char> names;
+		size_t names_size = 0;
+		ItemSet item_locations;
+		std::vector<std::pair<std::string_view, std::string_view>> transitions; //placed door pairs, area and room modes only
+		RandoSettings settings;
+	};
+
+	inline std::string_view SpaceToUnderscore(std::string_view str, ParsedSpoilerLog& log) {
+		if (str.find(' ') == std::string_view::npos) {
+			return str;
+		}
+		char* res = log.names.data() + log.names_size;
+		for (size_t i = 0; i < str.length(); i++) {
+			res[i] = str[i] == ' ' ? '_' : str[i];
+		}
+		log.names_size += str.length();
+		return std::string_view(res, str.length());
+	}
+
+	inline Item ParseRegularItem(std::string_view log_line, ParsedSpoilerLog& log) {
+		Item item;
+		size_t name_begin = log_line.find(") "), name_end = log_line.find("<---at--->");
+		if (name_begin == std::string_view::npos || name_end == std::string_view::npos || name_end < name_begin + 2) {
+			throw std::logic_error("Bad line : " + std::string(log_line));
+		}
+		item.name = SpaceToUnderscore(log_line.substr(name_begin + 2, name_end - name_begin - 2), log);
+		std::string_view location = log_line.substr(name_end + 10);
+		size_t cost_begin = location.find('[');
+		if (cost_begin != std::string_view::npos) {
+			std::string_view cost = location.substr(cost_begin + 1);
+			location = location.substr(0, cost_begin == 0 ? 0 : cost_begin - 1); //get rid of space between item and '[cost]'
+			size_t i = 0;
+			for (; i < cost.length() && cost[i] != ' '; i++) {
+				item.cost = item.cost * 10 + (cost[i] - '0');
+			}
+			std::string_view cost_type_short = cost.substr(std::min(i + 1, cost.length()), 2);
+			if (cost_type_short == "Gr")
+				item.cost_type = ItemCost::kGrub;
+			else if (cost_type_short == "Es")
+				item.cost_type = ItemCost::kEssence;
+		}
+		item.location = SpaceToUnderscore(location, log);
+
+		if (!item.name.empty() && item.name.back() == ')') { //dupe item
+			item.name = item.name.substr(0, item.name.length() < 4 ? 0 : item.name.length() - 4);
+		}
+
+		if (item.location == "King's_Idol-Glade_of_Hope") {
+			item.cost_type = ItemCost::kEssence;
+			item.cost = 200;
+		}
+
+		return item;
+	}
+
+	inline bool IsTransitionLine(std::string_view log_line) {
+		return log_line.find(" --> ") != std::string_view::npos;
+	}
+
+	//"(n) Scene[door] --> Scene[door]", the number is optional
+	inline std::pair<std::string_view, std::string_view> ParseTransition(std::string_view log_line) {
+		size_t arrow = log_line.find(" --> ");
+		size_t from_begin = log_line[0] == '(' && log_line.find(") ") < arrow ? log_line.find(") ") + 2 : 0;
+		std::string_view from = log_line.substr(from_begin, arrow - from_begin), to = log_line.substr(arrow + 5);
+		if (from.empty() || to.empty()) {
+			throw std::logic_error("Bad line : " + std::string(log_line));
+		}
+		return std::make_pair(from, to);
+	}
+
+	//Reads the progression items, the misc items from the area listing and the settings in one pass over the log. res
+	//keeps its buffers from the previous log, item_locations starts over with the same allocator
+	inline void ParseSpoilerLog(std::string_view spoiler_log, ParsedSpoilerLog& res) {
+		enum class Section {
+			kPreamble, kProgression, kTransitions, kAllItems, kSettings, kQualityOfLife
+		};
+
+		res.names.resize(spoiler_log.length());
+		res.names_size = 0;
+		res.item_locations = ItemSet(res.item_locations.get_allocator()); //a fresh set, clear() would keep the buckets and change the order
+		res.transitions.clear();
+		res.settings.mode = RandoMode::kItem;
+		res.settings.start_location.clear();
+		res.settings.start_name.clear();
+		res.settings.randomized_grubs = res.settings.randomized_roots = false;
+		Section section = Section::kPreamble;
+		std::string_view cur_area = "";
+		bool found_mode = false, found_start_location = false;
+		for (size_t line_begin = 0; line_begin < spoiler_log.length() && section != Section::kQualityOfLife;) {
+			size_t line_end = spoiler_log.find('\n', line_begin);
+			if (line_end == std::string_view::npos) {
+				line_end = spoiler_log.length();
+			}
+			std::string_view line = spoiler_log.substr(line_begin, line_end - line_begin);
+			line_begin = line_end + 1;
+			if (!line.empty() && line.back() == '\r') {
+				line.remove_suffix(1);
+			}
+
+			if (line == "TRANSITIONS" && section < Section::kSettings) {
+				section = Section::kTransitions;
+				continue;
+			} else if (IsTransitionLine(line) && section < Section::kSettings) { //transition modes list them among the items too
+				res.transitions.push_back(ParseTransition(line));
+				continue;
+			}
+
+			switch (section) {
+			case Section::kPreamble:
+				if (line == "PROGRESSION ITEMS") {
+					section = Section::kProgression;
+				}
+				break;
+			case Section::kTransitions: //area headers are all that is left in it
+				if (line == "PROGRESSION ITEMS") {
+					section = Section::kProgression;
+				} else if (line == "ALL ITEMS") {
+					section = Section::kAllItems;
+				} else if (line == "SETTINGS") {
+					section = Section::kSettings;
+				}
+				break;
+			case Section::kProgression:
+				if (line == "ALL ITEMS") {
+					section = Section::kAllItems;
+				} else if (!line.empty()) {
+					res.item_locations.insert(ParseRegularItem(line, res));
+				}
+				break;
+			case Section::kAllItems:
+				if (line == "SETTINGS") {
+					section = Section::kSettings;
+				} else if (line.empty()) {
+					break;
+				} else if (line.find(':') != std::string_view::npos) {
+					size_t area_begin = line[0] == '(' && line.find(") ") != std::string_view::npos ? line.find(") ") + 2 : 0;
+					cur_area = SpaceToUnderscore(line.substr(area_begin, line.length() - area_begin - 1), res);
+				} else if (line[0] == '(') {
+					Item item = ParseRegularItem(line, res);
+					if (misc_charms.count(item.name) || item.name.compare(0, 8, "Pale_Ore") == 0) {
+						res.item_locations.insert(item);
+					}
+				} else {
+					size_t cost_begin = line.find('[');
+					if (cost_begin == std::string_view::npos || cost_begin == 0) {
+						throw std::logic_error("Bad line : " + std::string(line));
+					}
+					std::string_view item_name = SpaceToUnderscore(line.substr(0, cost_begin - 1), res);
+					if (misc_charms.count(item_name)) {
+						res.item_locations.insert(Item(item_name, cur_area));
+					}
+				}
+				break;
+			case Section::kSettings: {
+				if (line == "QUALITY OF LIFE") {
+					section = Section::kQualityOfLife;
+					break;
+				}
+				size_t colon = line.find(": ");
+				if (colon == std::string_view::npos) { //subsection header
+					break;
+				}
+				std::string_view key = line.substr(0, colon), value = line.substr(colon + 2);
+				if (key == "Mode") {
+					if (value == "Item Randomizer") {
+						res.settings.mode = RandoMode::kItem;
+					} else if (value == "Area Randomizer") {
+						res.settings.mode = RandoMode::kArea;
+					} else if (value == "Room Randomizer" || value == "Connected-Area Room Randomizer") {
+						res.settings.mode = RandoMode::kRoom;
+					} else {
+						throw std::logic_error("Unknown mode: " + std::string(value));
+					}
+					found_mode = true;
+				} else if (key == "Start location") {
+					auto start_location = start_location_lookup.find(value);
+					if (start_location == start_location_lookup.end()) {
+						throw std::logic_error("Unknown start location: " + std::string(value));
+					}
+					res.settings.start_location = start_location->second;
+					res.settings.start_name = value;
+					found_start_location = true;
+				} else if (key == "Grubs") {
+					res.settings.randomized_grubs = value.compare(0, 4, "True") == 0;
+				} else if (key == "Whispering roots") {
+					res.settings.randomized_roots = value.compare(0, 4, "True") == 0;
+				}
+				break;
+			}
+			case Section::kQualityOfLife:
+				break;
+			}
+		}
+
+		if (section != Section::kSettings && section != Section::kQualityOfLife) {
+			throw std::logic_error("Error parsing spoiler log (missing settings)");
+		} else if (!found_mode) {
+			throw std::logic_error("Error parsing spoiler log (mode)");
+		} else if (!found_start_location) {
+			throw std::logic_error("Error parsing spoiler log (start location)");
+		} else if (res.settings.mode != RandoMode::kItem && res.transitions.empty()) {
+			throw std::logic_error("Error parsing spoiler log (no transitions)");
+		}
+	}
+
+	inline ParsedSpoilerLog ParseSpoilerLog(std::string_view spoiler_log) {
+		ParsedSpoilerLog res;
+		ParseSpoilerLog(spoiler_log, res);
+		return res;
+	}
+
+	const char* const kParsedLogicPath = "XML/parsed.xml";
+	const char* const kCompiledLogicPath = "XML/parsed.bin";
+	const char* const kAdditiveItemsPath = "XML/additive.xml";
+	const char* const kItemsPath = "XML/items.xml";
+
+	inline CompileOptions DefaultCompileOptions(bool ignore_bad_difficulty, const std::string& xml_directory = kXmlDirectory) {
+		CompileOptions options;
+		options.ignored_macros.assign(ignored_macros.begin(), ignored_macros.end());
+		options.additive_path = XmlPathIn(xml_directory, kAdditiveItemsPath);
+		options.items_path = XmlPathIn(xml_directory, kItemsPath);
+		options.ignore_bad_difficulty = ignore_bad_difficulty;
+		return options;
+	}
+
+#if defined(RANDORATER_EMBEDDED_LOGIC)
+	//The logic generated into embeddedlogic.hpp by logiccodegen --embed, viewed in place without any I/O or allocation
+	inline CompiledLogic EmbeddedLogic() {
+		CompiledLogic logic;
+		if (!ViewLogicImage((const char*) kEmbeddedLogicImage, kEmbeddedLogicImageSize, nullptr, logic)) {
+			throw std::logic_error("Embedded logic is malformed, run logiccodegen --embed again");
+		}
+		return logic;
+	}
+#endif
+
+	const signed char kUnevaluated = 0, kUnreachable = -1, kInProgress = -2;
+
+	enum class EvaluationMode {
+		kRecursive, //every loadout of a location is evaluated symbol by symbol
+		kBitset, //location loadouts that can be decided from the acquired symbols alone are, through their masks
+		kFixpoint //every macro is solved whenever an item is acquired (see SolveMacros), so locations never evaluate macros
+	};
+
+	//How one check fared during a rating
+	struct CheckReport {
+		int step = -1; //taken as the step-th check, -1 if it never was
+		int sphere = -1; //0 if in logic from the start, else one more than the sphere of the check whose item put it in logic, -1 if never in logic
+		long long int rating = -1; //lowest rating it was in logic at until it was taken
+		int loadout = -1; //location loadout giving that rating, -1 in area and room modes
+	};
+
+	struct EvaluationOptions {
+		EvaluationMode mode = EvaluationMode::kFixpoint;
+		std::ostream* debug_log = nullptr;
+		std::vector<CheckReport>* report = nullptr; //filled with one entry per placement if set
+		bool past_radiance = false; //keep taking checks once Radiance is in logic, until none are left
+	};
+
+	struct EvaluationState {
+		std::vector<long long int> acquired; //rating each symbol was acquired at, -1 if not acquired
+		std::vector<signed char> cache; //failed evaluations, kept until a symbol they depend on is acquired
+		std::vector<int> cache_step; //progression step each cache entry was last used in
+		std::vector<char> tainted; //failure saw an evaluation still in progress, so it only holds for the current step
+		std::function<void(SymbolId)> on_acquire; //called whenever a macro evaluates successfully for the first time
+		std::ostream* debug_log = nullptr;
+		int step = 0;
+		bool saw_in_progress = false;
+		EvaluationMode mode = EvaluationMode::kRecursive;
+		std::vector<uint64_t> available; //acquired or ignored symbols
+		std::vector<unsigned char> location_status; //LoadoutStatus of every location loadout
+		std::vector<int> location_status_stamp; //items_acquired when each location's statuses were last updated
+		int items_acquired = 0;
+		int macro_count;
+		std::vector<long long int> macro_value; //kFixpoint only, rating of each unacquired macro while its component is solved
+		std::vector<int> worklist;
+		std::vector<char> queued;
+
+		EvaluationState(const CompiledLogic& logic) : acquired(logic.symbols.size()), cache(logic.symbols.size()), cache_step(logic.symbols.size()),
+			tainted(logic.symbols.size()), available(logic.mask_words), location_status(logic.location_logic.LoadoutCount()),
+			location_status_stamp(logic.location_logic.EntryCount()), macro_count(logic.macro_count), macro_value(logic.macro_count),
+			queued(logic.macro_count) {
+			Reset(logic);
+		}
+
+		//Back to nothing acquired, keeping every buffer
+		void Reset(const CompiledLogic& logic) {
+			std::fill(acquired.begin(), acquired.end(), -1);
+			std::fill(cache.begin(), cache.end(), kUnevaluated);
+			std::fill(cache_step.begin(), cache_step.end(), 0);
+			std::fill(tainted.begin(), tainted.end(), 0);
+			std::fill(available.begin(), available.end(), 0);
+			for (SymbolId symbol = 0; symbol < logic.symbols.size(); symbol++) {
+				if (logic.ignored[symbol]) {
+					SetMaskBit(available.data(), symbol);
+				}
+			}
+			std::fill(location_status_stamp.begin(), location_status_stamp.end(), -1);
+			std::fill(macro_value.begin(), macro_value.end(), kBigNumber);
+			std::fill(queued.begin(), queued.end(), 0);
+			worklist.clear();
+			on_acquire = nullptr;
+			debug_log = nullptr;
+			step = 0;
+			saw_in_progress = false;
+			mode = EvaluationMode::kRecursive;
+			items_acquired = 0;
+		}
+
+		void Acquire(SymbolId symbol, long long int rating) {
+			acquired[symbol] = rating;
+			SetMaskBit(available.data(), symbol);
+			if (symbol >= macro_count) { //acquiring a macro can only turn undecided loadouts into satisfied ones
+				items_acquired++;
+			}
+		}
+	};
+
+	//Blocked loadouts would fail at their first missing symbol, an item, and satisfied ones only add up acquired ratings,
+	//so neither needs to be walked symbol by symbol and the result is the same as if they were. Only items unblock
+	//loadouts, so statuses are reused until the next item is acquired
+	inline void UpdateLoadoutStatus(SymbolId location, const CompiledLogic& logic, EvaluationState& state) {
+		if (state.location_status_stamp[location] != state.items_acquired) {
+			const LoadoutTable& table = logic.location_logic;
+#if defined(RANDORATER_EMBEDDED_LOGIC)
+			if (logic.mask_words == kEmbeddedMaskWords) { //a constant lets the compiler unroll the mask loops
+				ClassifyLoadouts(table.masks.data, kEmbeddedMaskWords, table.entry_begin[location], table.entry_begin[location + 1], state.available.data(),
+					logic.macro_mask.data, state.location_status.data());
+				state.location_status_stamp[location] = state.items_acquired;
+				return;
+			}
+#endif
+			ClassifyLoadouts(table.masks.data, logic.mask_words, table.entry_begin[location], table.entry_begin[location + 1], state.available.data(),
+				logic.macro_mask.data, state.location_status.data());
+			state.location_status_stamp[location] = state.items_acquired;
+		}
+	}
+
+	inline long long int AvailableLoadoutRating(const LoadoutTable& table, int loadout, const CompiledLogic& logic, const EvaluationState& state) {
+		long long int rating = 0;
+		for (int s = table.loadout_begin[loadout]; s < table.loadout_begin[loadout + 1]; s++) {
+			rating += logic.ignored[table.symbols[s]] ? 0 : state.acquired[table.symbols[s]];
+		}
+		return rating;
+	}
+
+	inline long long int EvaluateMacro(SymbolId macro, const CompiledLogic& logic, EvaluationState& state) {
+		RANDORATER_COUNT(kMacroEvaluations);
+		if (logic.ignored[macro]) {
+			return 0;
+		}
+
+		if (state.acquired[macro] >= 0) {
+			RANDORATER_COUNT(kMacroCacheHits);
+			return state.acquired[macro];
+		}
+
+		if (state.cache[macro] != kUnevaluated) {
+			RANDORATER_COUNT(kMacroCacheHits);
+			if (state.cache[macro] == kInProgress || state.tainted[macro]) {
+				state.saw_in_progress = true;
+			}
+			state.cache_step[macro] = state.step;
+			return state.cache[macro];
+		}
+
+		if (!logic.IsMacro(macro)) { //unacquired item (or typo)
+			return -1;
+		}
+
+		RANDORATER_COUNT(kMacroCacheMisses);
+		RANDORATER_TRACE_DETAIL("EvaluateMacro", logic.symbols.Name(macro));
+		bool uncertain = false, outer_saw_in_progress = state.saw_in_progress;
+		state.saw_in_progress = false;
+		state.cache[macro] = kInProgress;
+		state.cache_step[macro] = state.step;
+		long long int macro_rating = kBigNumber;
+		const LoadoutTable& table = logic.macro_logic;
+		for (int l = table.entry_begin[macro]; l < table.entry_begin[macro + 1]; l++) {
+			RANDORATER_COUNT(kLoadoutsExamined);
+			long long int loadout_rating = 0;
+			for (int s = table.loadout_begin[l]; s < table.loadout_begin[l + 1]; s++) {
+				long long int evaluation = EvaluateMacro(table.symbols[s], logic, state);
+				if (evaluation < 0) {
+					if (evaluation == kInProgress) {
+						uncertain = true;
+					}
+					loadout_rating = kBigNumber; //prevents overriding macro_rating with invalid value
+					break;
+				}
+				loadout_rating += evaluation;
+			}
+			macro_rating = std::min(macro_rating, std::max(loadout_rating, kTensTable[table.difficulties[l]]));
+		}
+
+		if (macro_rating == kBigNumber) {
+			macro_rating = -1;
+		}
+
+		if (macro_rating > -1) {
+			state.Acquire(macro, macro_rating);
+			state.cache[macro] = kUnevaluated;
+			if (state.on_acquire) {
+				state.on_acquire(macro);
+			}
+		} else if (uncertain) {
+			RANDORATER_COUNT(kUncertainMacros);
+			state.cache[macro] = kUnevaluated;
+		} else {
+			state.cache[macro] = kUnreachable;
+			state.tainted[macro] = state.saw_in_progress;
+		}
+		state.saw_in_progress = state.saw_in_progress || outer_saw_in_progress;
+
+		return macro_rating;
+	}
+
+	//Rating of a macro loadout from acquired symbols and the current values of macros in the component being solved,
+	//at least kBigNumber if a symbol is unavailable
+	inline long long int FixpointLoadoutRating(const LoadoutTable& table, int loadout, const CompiledLogic& logic, const EvaluationState& state) {
+		long long int rating = 0;
+		for (int s = table.loadout_begin[loadout]; s < table.loadout_begin[loadout + 1]; s++) {
+			SymbolId symbol = table.symbols[s];
+			long long int value = logic.ignored[symbol] ? 0 : state.acquired[symbol] >= 0 ? state.acquired[symbol]
+				: logic.IsMacro(symbol) ? state.macro_value[symbol] : kBigNumber;
+			if (value >= kBigNumber) {
+				return kBigNumber;
+			}
+			rating += value;
+		}
+		return std::max(rating, kTensTable[table.difficulties[loadout]]);
+	}
+
+	//Acquires every macro that the acquired symbols make reachable, at the lowest rating any of its loadouts allows.
+	//Components of the macro graph are solved in dependency order, each by lowering its members' ratings from unreachable
+	//until none drops any further, so a macro's rating never depends on the order symbols or cycles are visited in.
+	//Members are only acquired once their component is solved, like items their rating never changes afterwards
+	inline void SolveMacros(const CompiledLogic& logic, EvaluationState& state) {
+		RANDORATER_TRACE("SolveMacros");
+		const LoadoutTable& table = logic.macro_logic;
+		bool acquired_any = false;
+		for (int c = 0; c + 1 < logic.component_begin.size(); c++) {
+			for (int i = logic.component_begin[c]; i < logic.component_begin[c + 1]; i++) {
+				SymbolId macro = logic.macro_order[i];
+				if (state.acquired[macro] < 0 && !logic.ignored[macro]) {
+					state.macro_value[macro] = kBigNumber;
+					state.worklist.push_back(macro);
+					state.queued[macro] = 1;
+				}
+			}
+			while (!state.worklist.empty()) {
+				SymbolId macro = state.worklist.back();
+				state.worklist.pop_back();
+				state.queued[macro] = 0;
+				RANDORATER_COUNT(kMacroEvaluations);
+				long long int macro_rating = kBigNumber;
+				for (int l = table.entry_begin[macro]; l < table.entry_begin[macro + 1]; l++) {
+					RANDORATER_COUNT(kLoadoutsExamined);
+					macro_rating = std::min(macro_rating, FixpointLoadoutRating(table, l, logic, state));
+				}
+				if (macro_rating < state.macro_value[macro]) {
+					state.macro_value[macro] = macro_rating;
+					for (const int* m = logic.macro_dependents.First(macro); m != logic.macro_dependents.Last(macro); m++) {
+						if (logic.macro_component[*m] == c && state.acquired[*m] < 0 && !logic.ignored[*m] && !state.queued[*m]) {
+							state.worklist.push_back(*m);
+							state.queued[*m] = 1;
+						}
+					}
+				}
+			}
+			for (int i = logic.component_begin[c]; i < logic.component_begin[c + 1]; i++) {
+				SymbolId macro = logic.macro_order[i];
+				if (state.acquired[macro] < 0 && !logic.ignored[macro] && state.macro_value[macro] < kBigNumber) {
+					state.Acquire(macro, state.macro_value[macro]);
+					acquired_any = true;
+					if (state.on_acquire) {
+						state.on_acquire(macro);
+					}
+				}
+			}
+		}
+		if (acquired_any) { //loadouts missing only these macros are no longer blocked, so their statuses are stale
+			state.items_acquired++;
+		}
+	}
+
+	inline long long int EvaluateLocation(SymbolId location, const CompiledLogic& logic, EvaluationState& state, int* best_loadout = nullptr) {
+		if (DEBUG && state.debug_log != nullptr) {
+			*state.debug_log << "Location " << logic.locations.Name(location) << std::endl;
+			std::cout << "Location " << logic.locations.Name(location) << std::endl;
+		}
+		RANDORATER_COUNT(kLocationEvaluations);
+		RANDORATER_TRACE_DETAIL("EvaluateLocation", logic.locations.Name(location));
+		state.saw_in_progress = false;
+		long long int easiest_loadout_rating = kBigNumber;
+		const LoadoutTable& table = logic.location_logic;
+		bool use_masks = state.mode != EvaluationMode::kRecursive;
+		if (use_masks) {
+			UpdateLoadoutStatus(location, logic, state);
+		}
+		for (int l = table.entry_begin[location]; l < table.entry_begin[location + 1]; l++) {
+			RANDORATER_COUNT(kLoadoutsExamined);
+			long long int cur_loadout_rating = 0;
+			if (use_masks && (state.location_status[l] != kLoadoutUndecided || state.mode == EvaluationMode::kFixpoint)) {
+				if (state.location_status[l] != kLoadoutSatisfied) { //a macro still missing after SolveMacros is unreachable
+					continue;
+				}
+				cur_loadout_rating = AvailableLoadoutRating(table, l, logic, state);
+			} else {
+				for (int s = table.loadout_begin[l]; s < table.loadout_begin[l + 1]; s++) {
+					SymbolId symbol = table.symbols[s];
+					long long int symbol_rating = EvaluateMacro(symbol, logic, state);
+					if (symbol_rating < 0) {
+						if (symbol_rating == kUnreachable && state.cache[symbol] == kUnevaluated) {
+							state.cache[symbol] = kUnreachable;
+							state.cache_step[symbol] = state.step;
+							state.tainted[symbol] = state.saw_in_progress;
+						}
+						cur_loadout_rating = kBigNumber;
+						break;
+					}
+					cur_loadout_rating += symbol_rating;
+				}
+			}
+			long long int loadout_rating = std::max(cur_loadout_rating, kTensTable[table.difficulties[l]]);
+			if (loadout_rating < easiest_loadout_rating) {
+				easiest_loadout_rating = loadout_rating;
+				if (best_loadout != nullptr) {
+					*best_loadout = l;
+				}
+			}
+		}
+		return easiest_loadout_rating == kBigNumber ? -1 : easiest_loadout_rating;
+	}
+
+	inline SymbolId FindLocation(const CompiledLogic& logic, std::string_view location) {
+		SymbolId id = logic.locations.Find(location);
+		if (id == kNoSymbol) {
+			throw std::logic_error("Unknown location " + std::string(location));
+		}
+		return id;
+	}
+
+	struct Placement {
+		SymbolId location;
+		SymbolId item; //kNoSymbol if no loadout mentions it
+		int chain; //additive group (see CompiledLogic::chain_begin), -1 if not additive
+		bool grub;
+		int essence;
+		const Item* source;
+	};
+
+	//Keeps the result of every check between progression steps and only re-evaluates checks whose logic mentions a symbol
+	//acquired since, which reproduces the step-by-step full re-evaluation of every remaining check: failures cached during
+	//a step stay cached until the step ends, failures from earlier steps are invalidated as soon as a dependency is acquired
+	struct Frontier {
+		const CompiledLogic& logic;
+		const std::vector<Placement>* placements = nullptr;
+		EvaluationState* state = nullptr;
+		TransitionGraph* graph = nullptr; //rates the checks instead of their loadouts in area and room modes
+		std::vector<CheckReport>* report = nullptr;
+		int sphere = 0; //of checks coming into logic now, only kept for the report
+		std::vector<std::vector<int>> placements_at; //placements per location id
+		std::vector<long long int> ratings; //latest rating per placement, -1 if unreachable
+		std::vector<char> checked, eligible;
+		std::vector<uint64_t> dirty; //bitset of placements to (re)evaluate during the current pass
+		std::vector<int> dirty_next_step;
+		std::vector<SymbolId> deferred; //failures from this step invalidated by an acquisition later in the same step
+		std::vector<SymbolId> stack;
+		std::vector<int> visited;
+		int visit_stamp = 0;
+		int pass_position = -1;
+		std::vector<std::pair<long long int, int>> reachable; //min-heap of (rating, placement)
+		std::vector<std::pair<int, int>> grub_gated, essence_gated; //(cost, placement) sorted by cost
+		size_t grubs_unlocked = 0, essence_unlocked = 0;
+		int grub_count = 0, essence_count = 0;
+
+		explicit Frontier(const CompiledLogic& logic) : logic(logic), placements_at(logic.locations.size()), visited(logic.symbols.size(), 0) {}
+
+		//Starts over on new placements, keeping every buffer. Every placement is dirty and only the ungated ones eligible
+		void Reset(const std::vector<Placement>& new_placements, EvaluationState& new_state, TransitionGraph* new_graph = nullptr,
+			std::vector<CheckReport>* new_report = nullptr) {
+			for (auto& at : placements_at) {
+				at.clear();
+			}
+			placements = &new_placements;
+			state = &new_state;
+			graph = new_graph;
+			report = new_report;
+			sphere = 0;
+			size_t count = new_placements.size();
+			ratings.assign(count, -1);
+			checked.assign(count, 0);
+			eligible.assign(count, 1);
+			dirty.assign((count + 63) / 64, 0);
+			dirty_next_step.clear();
+			deferred.clear();
+			reachable.clear();
+			grub_gated.clear();
+			essence_gated.clear();
+			grubs_unlocked = essence_unlocked = 0;
+			grub_count = essence_count = 0;
+			pass_position = -1;
+			if (report != nullptr) {
+				report->assign(count, CheckReport());
+			}
+			for (int p = 0; p < (int) count; p++) {
+				const Item& item = *new_placements[p].source;
+				if (new_placements[p].location != kNoSymbol) {
+					placements_at[new_placements[p].location].push_back(p);
+				}
+				if (item.cost_type == ItemCost::kGrub && item.cost > 0) {
+					grub_gated.push_back(std::make_pair(item.cost, p));
+					eligible[p] = 0;
+				} else if (item.cost_type == ItemCost::kEssence && item.cost > 0) {
+					essence_gated.push_back(std::make_pair(item.cost, p));
+					eligible[p] = 0;
+				}
+				SetMaskBit(dirty.data(), p);
+			}
+			std::sort(grub_gated.begin(), grub_gated.end());
+			std::sort(essence_gated.begin(), essence_gated.end());
+			state->on_acquire = [this](SymbolId symbol) { OnAcquire(symbol); };
+		}
+
+		~Frontier() {
+			if (state != nullptr) {
+				state->on_acquire = nullptr;
+			}
+		}
+
+		Frontier(const Frontier&) = delete;
+		Frontier& operator=(const Frontier&) = delete;
+
+		//First dirty placement after position, -1 if none
+		int NextDirty(int position) const {
+			for (size_t word = (position + 1) / 64; word < dirty.size(); word++) {
+				uint64_t bits = dirty[word];
+				if (word == (size_t) (position + 1) / 64) {
+					bits &= ~0ull << ((position + 1) % 64);
+				}
+				if (bits != 0) {
+					return (int) (word * 64 + CountTrailingZeros(bits));
+				}
+			}
+			return -1;
+		}
+
+		void MarkDirty(int placement) {
+			if (checked[placement]) {
+				return;
+			} else if (placement > pass_position) {
+				SetMaskBit(dirty.data(), placement);
+			} else {
+				dirty_next_step.push_back(placement);
+			}
+		}
+
+		//Invalidates failures depending on a newly acquired symbol and marks the checks whose logic they appear in
+		void Propagate(SymbolId symbol, bool mid_step) {
+			visit_stamp++;
+			stack.clear();
+			stack.push_back(symbol);
+			while (!stack.empty()) {
+				SymbolId changed = stack.back();
+				stack.pop_back();
+				for (const int* l = logic.location_dependents.First(changed); graph == nullptr && l != logic.location_dependents.Last(changed); l++) {
+					for (int placement : placements_at[*l]) {
+						MarkDirty(placement);
+					}
+				}
+				for (const int* m = logic.macro_dependents.First(changed); m != logic.macro_dependents.Last(changed); m++) {
+					if (visited[*m] == visit_stamp || state->acquired[*m] >= 0 || state->cache[*m] == kInProgress) {
+						continue;
+					}
+					visited[*m] = visit_stamp;
+					if (mid_step && state->cache[*m] == kUnreachable && state->cache_step[*m] == state->step) {
+						deferred.push_back(*m);
+						continue;
+					}
+					state->cache[*m] = kUnevaluated;
+					state->tainted[*m] = 0;
+					stack.push_back(*m);
+				}
+			}
+		}
+
+		//Every acquired symbol, items as they are taken and macros as they are solved
+		void OnAcquire(SymbolId symbol) {
+			if (graph != nullptr) {
+				graph->Acquire(symbol);
+			}
+			Propagate(symbol, true);
+		}
+
+		//Settles whatever the acquisitions since the last call opened up and marks the checks it made easier
+		void ExpandGraph() {
+			if (graph == nullptr) {
+				return;
+			}
+			graph->Expand();
+			for (SymbolId location : graph->changed_locations) {
+				for (int placement : placements_at[location]) {
+					MarkDirty(placement);
+				}
+			}
+			graph->changed_locations.clear();
+		}
+
+		void Unlock(std::vector<std::pair<int, int>>& gated, size_t& unlocked, int count) {
+			for (; unlocked < gated.size() && gated[unlocked].first <= count; unlocked++) {
+				eligible[gated[unlocked].second] = 1;
+				MarkDirty(gated[unlocked].second);
+			}
+		}
+
+		//Marks a check taken and counts its grub and essence, returns the item it gives, kNoSymbol if none or already acquired
+		SymbolId Take(int check) {
+			const Placement& placement = (*placements)[check];
+			SymbolId item = placement.item;
+			if (placement.grub) {
+				grub_count++;
+				Unlock(grub_gated, grubs_unlocked, grub_count);
+			}
+			if (placement.essence > 0) {
+				essence_count += placement.essence;
+				Unlock(essence_gated, essence_unlocked, essence_count);
+			}
+			if (placement.chain >= 0) {
+				item = kNoSymbol;
+				for (int l = logic.chain_begin[placement.chain]; l < logic.chain_begin[placement.chain + 1]; l++) {
+					if (state->acquired[logic.chain_levels[l]] < 0) {
+						item = logic.chain_levels[l];
+						break;
+					}
+				}
+			}
+			checked[check] = 1;
+			return item != kNoSymbol && state->acquired[item] < 0 ? item : kNoSymbol;
+		}
+
+		void EvaluateDirty() {
+			for (int next = NextDirty(pass_position); next >= 0; next = NextDirty(pass_position)) {
+				pass_position = next;
+				ClearMaskBit(dirty.data(), next);
+				if (checked[pass_position] || !eligible[pass_position]) {
+					continue;
+				}
+				const Placement& placement = (*placements)[pass_position];
+				SymbolId location = placement.location == kNoSymbol ? FindLocation(logic, placement.source->location) : placement.location;
+				int loadout = -1;
+				long long int rating = graph != nullptr ? graph->LocationRating(location)
+					: EvaluateLocation(location, logic, *state, report != nullptr ? &loadout : nullptr);
+				if (graph == nullptr && state->saw_in_progress) {
+					RANDORATER_COUNT(kLocationRetries);
+					dirty_next_step.push_back(pass_position);
+				}
+				ratings[pass_position] = rating;
+				if (rating >= 0 && report != nullptr) {
+					CheckReport& check = (*report)[pass_position];
+					check.sphere = check.sphere < 0 ? sphere : check.sphere;
+					check.rating = rating;
+					check.loadout = loadout;
+				}
+				if (rating >= 0) {
+					reachable.push_back(std::make_pair(rating, pass_position));
+					std::push_heap(reachable.begin(), reachable.end(), std::greater<std::pair<long long int, int>>());
+				}
+			}
+			pass_position = (int) placements->size();
+		}
+
+		int NextCheck() {
+			while (!reachable.empty()) {
+				auto next = reachable.front();
+				if (!checked[next.second] && ratings[next.second] == next.first) {
+					return next.second;
+				}
+				std::pop_heap(reachable.begin(), reachable.end(), std::greater<std::pair<long long int, int>>());
+				reachable.pop_back();
+			}
+			return -1;
+		}
+
+		void EndStep() {
+			state->step++;
+			for (SymbolId macro : deferred) {
+				if (state->acquired[macro] < 0 && state->cache[macro] == kUnreachable) {
+					state->cache[macro] = kUnevaluated;
+					state->tainted[macro] = 0;
+					Propagate(macro, false);
+				}
+			}
+			deferred.clear();
+			for (SymbolId symbol = 0; symbol < (int) state->cache.size(); symbol++) {
+				if (state->tainted[symbol]) {
+					state->cache[symbol] = kUnevaluated;
+					state->tainted[symbol] = 0;
+				}
+			}
+			for (int placement : dirty_next_step) {
+				SetMaskBit(dirty.data(), placement);
+			}
+			dirty_next_step.clear();
+			pass_position = -1;
+		}
+	};
+
+	struct SeedRating {
+		long long int raw = -1; //-1 if the seed cannot be completed
+		int checks_taken = 0;
+	};
+
+	//Where an item is placed and what acquiring it does, item names are looked up here once so rating only deals in ids
+	inline Placement MakePlacement(const CompiledLogic& logic, const Item& item) {
+		Placement placement { logic.locations.Find(item.location), logic.symbols.Find(item.name), -1, false, 0, &item };
+		if (placement.item != kNoSymbol) {
+			placement.chain = logic.item_chain[placement.item];
+			placement.grub = logic.item_grub[placement.item] != 0;
+			placement.essence = logic.item_essence[placement.item];
+		}
+		return placement;
+	}
+
+	//Checks that are not randomized with the seed's settings still hold grubs and essence
+	inline void AddDefaultItems(ParsedSpoilerLog& parsed) {
+		ItemSet& item_locations = parsed.item_locations;
+		const RandoSettings& settings = parsed.settings;
+		if (!settings.randomized_grubs) {
+			for (auto& grub : default_grub_locations) {
+				item_locations.insert(Item(grub));
+			}
+		}
+		for (auto& essence_reward : default_essence_rewards) {
+			if (!settings.randomized_roots || essence_reward.first.length() < 15) { //only dream warriors if roots are randomized
+				item_locations.insert(Item(essence_reward.first));
+			}
+		}
+	}
+
+	//Everything a rating needs besides the logic, sized for the logic once and reset before every rating, so rating seed
+	//after seed allocates nothing once the buffers have grown to the largest seed seen. Not thread safe, every thread
+	//needs its own
+	class RaterContext {
+	public:
+		//Area and room logic comes from transitions, or from the process wide cache reading kXmlDirectory if null
+		explicit RaterContext(const CompiledLogic& logic, TransitionLogicCache* transitions = nullptr) : logic(logic), state(logic), frontier(logic),
+			radiance(FindLocation(logic, "Radiance")), transitions(transitions != nullptr ? *transitions : TransitionLogicCache::Process()) {
+			parsed.item_locations = ItemSet(ArenaAllocator<Item>(&item_arena));
+		}
+
+		RaterContext(const RaterContext&) = delete;
+		RaterContext& operator=(const RaterContext&) = delete;
+
+		//Order of placements decides which check is taken when several are equally easy
+		SeedRating RatePlacements(const std::vector<Placement>& placements, const std::vector<SymbolId>& starting_symbols,
+			const EvaluationOptions& options = EvaluationOptions()) {
+			return Rate(placements, starting_symbols, nullptr, options);
+		}
+
+		SeedRating RateSeed(std::string_view spoiler_log, const EvaluationOptions& options = EvaluationOptions()) {
+			ParseSeed(spoiler_log);
+			return RateParsed(options);
+		}
+
+		//The first half of RateSeed. The parsed log points into spoiler_log, which has to outlive RateParsed
+		void ParseSeed(std::string_view spoiler_log) {
+			RANDORATER_PHASE(kPhaseParseLog);
+			parsed.item_locations = ItemSet(ArenaAllocator<Item>(&item_arena));
+			item_arena.Reset(); //nothing points into the arena any more
+			ParseSpoilerLog(spoiler_log, parsed);
+			AddDefaultItems(parsed);
+			placements.clear();
+			for (auto& item : parsed.item_locations) { //iteration order of item_locations decides ties, so it is kept
+				placements.push_back(MakePlacement(logic, item));
+			}
+			FindStartingSymbols();
+		}
+
+		//ParseSeed for a log tokenized ahead of time, as in a seed corpus. Placements follow items in the order given instead
+		//of the iteration order of a parsed ItemSet, and Parsed().item_locations stays empty. Placements point into items
+		//and the parsed log into the names, so both have to outlive RateParsed
+		void LoadSeed(const RandoSettings& settings, const std::vector<Item>& items,
+			const std::vector<std::pair<std::string_view, std::string_view>>& transitions) {
+			RANDORATER_PHASE(kPhaseParseLog);
+			parsed.item_locations = ItemSet(ArenaAllocator<Item>(&item_arena));
+			item_arena.Reset();
+			parsed.names_size = 0;
+			parsed.transitions.assign(transitions.begin(), transitions.end());
+			parsed.settings = settings;
+			placements.clear();
+			for (auto& item : items) {
+				placements.push_back(MakePlacement(logic, item));
+			}
+			FindStartingSymbols();
+		}
+
+		//Rates the log last given to ParseSeed, which can be rated again with other options
+		SeedRating RateParsed(const EvaluationOptions& options = EvaluationOptions()) {
+			if (parsed.settings.mode == RandoMode::kItem) {
+				return RatePlacements(placements, starting_symbols, options);
+			}
+
+			PlaceTransitions();
+			EvaluationOptions graph_options = options;
+			graph_options.mode = EvaluationMode::kFixpoint; //the graph only sees macros once they are acquired
+			return Rate(placements, starting_symbols, graph.get(), graph_options);
+		}
+
+		//The log last given to RateSeed or ParseSeed
+		const ParsedSpoilerLog& Parsed() const {
+			return parsed;
+		}
+
+		//Placements of the log last given to RateSeed or ParseSeed, in the order of its report
+		const std::vector<Placement>& Placements() const {
+			return placements;
+		}
+
+	private:
+		const CompiledLogic& logic;
+		EvaluationState state;
+		Frontier frontier;
+		SymbolId radiance;
+		Arena item_arena;
+		ParsedSpoilerLog parsed;
+		std::vector<Placement> placements;
+		std::vector<SymbolId> starting_symbols;
+		TransitionLogicCache& transitions;
+		std::unique_ptr<TransitionGraph> graph; //made for the mode of the last area or room log
+		std::vector<std::pair<int, int>> placed_doors;
+
+		void FindStartingSymbols() {
+			starting_symbols.clear();
+			if (parsed.settings.mode == RandoMode::kItem) {
+				starting_symbols.push_back(logic.symbols.Find(parsed.settings.start_location));
+			}
+		}
+
+		//Points the graph at the transitions of the parsed log, loading the logic of its mode if the last log had another
+		void PlaceTransitions() {
+			if (graph == nullptr || graph->Logic().mode != parsed.settings.mode) {
+				graph = std::make_unique<TransitionGraph>(logic, transitions.Get(logic, parsed.settings.mode));
+			}
+			const TransitionLogic& transitions = graph->Logic();
+			placed_doors.clear();
+			for (auto& transition : parsed.transitions) {
+				int from = transitions.FindDoor(transition.first), to = transitions.FindDoor(transition.second);
+				if (from < 0 || to < 0) {
+					throw std::logic_error("Unknown transition " + std::string(from < 0 ? transition.first : transition.second));
+				}
+				placed_doors.push_back(std::make_pair(from, to));
+			}
+			auto start_door = transitions.start_doors.find(parsed.settings.start_name);
+			if (start_door == transitions.start_doors.end()) {
+				throw std::logic_error("No start transition for " + parsed.settings.start_name);
+			}
+			graph->Place(placed_doors, start_door->second);
+		}
+
+		SeedRating Rate(const std::vector<Placement>& placements, const std::vector<SymbolId>& starting_symbols, TransitionGraph* graph,
+			const EvaluationOptions& options) {
+			RANDORATER_PHASE(kPhaseRateProgression);
+			size_t remaining = placements.size();
+
+			state.Reset(logic);
+			state.debug_log = options.debug_log;
+			state.mode = options.mode;
+			int steps = 0;
+
+			for (SymbolId symbol : starting_symbols) {
+				if (symbol != kNoSymbol) {
+					state.Acquire(symbol, 0);
+				}
+			}
+
+			if (graph != nullptr) {
+				graph->Reset(state.acquired);
+			}
+			frontier.Reset(placements, state, graph, options.report);
+			SeedRating res;
+			if (state.mode == EvaluationMode::kFixpoint) {
+				SolveMacros(logic, state);
+			}
+			frontier.ExpandGraph();
+
+			do {
+				RANDORATER_COUNT(kProgressionSteps);
+				RANDORATER_TRACE("ProgressionStep");
+				frontier.EvaluateDirty();
+				int next_check = frontier.NextCheck();
+				if (next_check < 0) { //nothing left in logic, so the seed cannot be completed unless Radiance was already reached
+					return res;
+				}
+				if (options.report != nullptr) {
+					CheckReport& check = (*options.report)[next_check];
+					check.step = ++steps;
+					frontier.sphere = check.sphere + 1;
+				}
+
+				SymbolId item_at_check = frontier.Take(next_check);
+				remaining--;
+				if (res.raw < 0) {
+					res.checks_taken++;
+				}
+				if (item_at_check != kNoSymbol) {
+					state.Acquire(item_at_check, frontier.ratings[next_check]);
+					frontier.OnAcquire(item_at_check);
+					if (state.mode == EvaluationMode::kFixpoint) {
+						SolveMacros(logic, state);
+					}
+					frontier.ExpandGraph();
+				}
+
+				if (res.raw < 0) {
+					res.raw = EvaluateLocation(radiance, logic, state);
+				}
+				frontier.EndStep();
+			} while (remaining > 0 && (res.raw == -1 || options.past_radiance));
+
+			return res;
+		}
+	};
+
+	inline SeedRating RatePlacements(const CompiledLogic& logic, const std::vector<Placement>& placements,
+		const std::unordered_set<std::string>& starting_items, const EvaluationOptions& options = EvaluationOptions()) {
+		std::vector<SymbolId> starting_symbols;
+		for (auto& item : starting_items) {
+			starting_symbols.push_back(logic.symbols.Find(item));
+		}
+		RaterContext context(logic);
+		return context.RatePlacements(placements, starting_symbols, options);
+	}
+
+	inline SeedRating RateProgression(const CompiledLogic& logic, const ItemSet& item_locations,
+		const std::unordered_set<std::string>& starting_items, const EvaluationOptions& options = EvaluationOptions()) {
+		std::vector<Placement> placements; //iteration order of item_locations decides ties, so it is kept
+		for (auto& item : item_locations) {
+			placements.push_back(MakePlacement(logic, item));
+		}
+		return RatePlacements(logic, placements, starting_items, options);
+	}
+
+	inline SeedRating RateSeed(std::string_view spoiler_log, const CompiledLogic& logic, const EvaluationOptions& options = EvaluationOptions()) {
+		RaterContext context(logic);
+		return context.RateSeed(spoiler_log, options);
+	}
+
+	inline double Log10Rating(long long int raw) {
+		return raw == 0 ? 0 : log10(raw);
+	}
+}
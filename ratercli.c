@@ -0,0 +1,131 @@
+/*Rates spoiler logs through librandorater alone, as an example of its C interface. Prints one CSV line per log like
+  main --batch: ratercli [--ignore-bad-difficulty] [--xml <directory>] [--eval fixpoint|recursive|bitset] <log>...*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "randorater.h"
+
+static char* ReadFile(const char* path, size_t* length) {
+	FILE* file = fopen(path, "rb");
+	char* data = NULL;
+	size_t capacity = 0;
+	*length = 0;
+	if (file == NULL) {
+		return NULL;
+	}
+	for (;;) {
+		if (*length == capacity) {
+			char* grown = (char*) realloc(data, capacity = capacity * 2 + 65536);
+			if (grown == NULL) {
+				free(data);
+				fclose(file);
+				return NULL;
+			}
+			data = grown;
+		}
+		size_t read = fread(data + *length, 1, capacity - *length, file);
+		*length += read;
+		if (read == 0) {
+			break;
+		}
+	}
+	if (ferror(file)) {
+		free(data);
+		data = NULL;
+	}
+	fclose(file);
+	return data;
+}
+
+static void WriteCsvField(const char* field) {
+	if (strpbrk(field, ",\"\r\n") == NULL) {
+		fputs(field, stdout);
+		return;
+	}
+	putchar('"');
+	for (const char* c = field; *c != 0; c++) {
+		putchar(*c);
+		if (*c == '"') {
+			putchar('"');
+		}
+	}
+	putchar('"');
+}
+
+int main(int argc, char** argv) {
+	rr_logic_options logic_options;
+	rr_rate_options rate_options = { RR_EVAL_FIXPOINT };
+	int first_log = argc, failed = 0;
+	rr_logic_options_init(&logic_options);
+	for (int i = 1; i < argc && first_log == argc; i++) {
+		if (strcmp(argv[i], "--ignore-bad-difficulty") == 0) {
+			logic_options.ignore_bad_difficulty = 1;
+		} else if (strcmp(argv[i], "--xml") == 0 && i + 1 < argc) {
+			logic_options.xml_directory = argv[++i];
+		} else if (strcmp(argv[i], "--eval") == 0 && i + 1 < argc) {
+			i++;
+			if (strcmp(argv[i], "fixpoint") == 0) {
+				rate_options.eval_mode = RR_EVAL_FIXPOINT;
+			} else if (strcmp(argv[i], "recursive") == 0) {
+				rate_options.eval_mode = RR_EVAL_RECURSIVE;
+			} else if (strcmp(argv[i], "bitset") == 0) {
+				rate_options.eval_mode = RR_EVAL_BITSET;
+			} else {
+				printf("Unknown evaluation mode %s (expected bitset, fixpoint or recursive)\n", argv[i]);
+				return 1;
+			}
+		} else {
+			first_log = i;
+		}
+	}
+	if (first_log == argc) {
+		printf("Usage: ratercli [--ignore-bad-difficulty] [--xml <directory>] [--eval fixpoint|recursive|bitset] <log>...\n");
+		return 1;
+	}
+
+	char error[512];
+	rr_logic* logic;
+	rr_status status = rr_logic_load(&logic_options, &logic, error, sizeof(error));
+	if (status != RR_OK) {
+		printf("%s: %s\n", rr_status_name(status), error);
+		return 1;
+	}
+	rr_rater* rater;
+	if (rr_rater_create(logic, &rater) != RR_OK) {
+		printf("Unable to create a rater\n");
+		rr_logic_free(logic);
+		return 1;
+	}
+
+	printf("path,raw_rating,log10_rating,checks_taken,error\n");
+	for (int i = first_log; i < argc; i++) {
+		size_t length;
+		char* log = ReadFile(argv[i], &length);
+		rr_result result;
+		WriteCsvField(argv[i]);
+		if (log == NULL) {
+			printf(",-1,,0,");
+			WriteCsvField("Unable to open spoiler log");
+			putchar('\n');
+			failed++;
+			continue;
+		}
+		status = rr_rate_log(rater, log, length, &rate_options, &result);
+		free(log);
+		if (status != RR_OK) {
+			printf(",-1,,0,");
+			WriteCsvField(rr_rater_error(rater));
+			failed++;
+		} else if (result.completable) {
+			printf(",%lld,%g,%d,", result.raw_rating, result.log10_rating, result.checks_taken);
+		} else {
+			printf(",-1,,%d,", result.checks_taken);
+		}
+		putchar('\n');
+	}
+	rr_rater_free(rater);
+	rr_logic_free(logic);
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "compiledlogic.hpp"
+
+//Framing for --serve. A request is a header line "<kind> <length>\n" followed by length bytes of payload, kind being
+//log (the spoiler log itself), path (of a spoiler log) or reload (empty payload). Every request gets one response, a
+//header line "<length>\n" followed by length bytes of payload
+namespace RandoRater {
+
+	const size_t kMaxServeRequest = 64 << 20;
+
+	struct ServeRequest {
+		std::string kind;
+		std::string payload;
+	};
+
+	//Logic shared by every worker. Requests keep the logic they started with alive, so reloading never waits for them
+	//and never pulls a table out from under them
+	class LogicHolder {
+	public:
+		explicit LogicHolder(std::shared_ptr<const CompiledLogic> logic) : logic(std::move(logic)) {}
+
+		std::shared_ptr<const CompiledLogic> Get() {
+			std::lock_guard<std::mutex> guard(lock);
+			return logic;
+		}
+
+		void Set(std::shared_ptr<const CompiledLogic> new_logic) {
+			std::lock_guard<std::mutex> guard(lock);
+			logic = std::move(new_logic);
+		}
+
+	private:
+		std::mutex lock;
+		std::shared_ptr<const CompiledLogic> logic;
+	};
+
+	//Called with the index of the worker answering the request, below the worker_count given to Serve
+	typedef std::function<std::string(int worker, const ServeRequest&)> ServeHandler;
+
+#ifndef _WIN32
+
+	inline bool ReadFully(int fd, char* data, size_t size) {
+		while (size > 0) {
+			ssize_t count = read(fd, data, size);
+			if (count < 0 && errno == EINTR) {
+				continue;
+			} else if (count <= 0) {
+				return false;
+			}
+			data += count;
+			size -= count;
+		}
+		return true;
+	}
+
+	inline bool WriteFully(int fd, const char* data, size_t size) {
+		while (size > 0) {
+			ssize_t count = write(fd, data, size);
+			if (count < 0 && errno == EINTR) {
+				continue;
+			} else if (count <= 0) {
+				return false;
+			}
+			data += count;
+			size -= count;
+		}
+		return true;
+	}
+
+	//False at the end of the stream, throws if the header is malformed since the stream cannot be resynchronized
+	inline bool ReadServeRequest(int fd, ServeRequest& request) {
+		std::string header;
+		char c;
+		while (true) {
+			if (!ReadFully(fd, &c, 1)) {
+				if (header.empty()) {
+					return false;
+				}
+				throw std::runtime_error("Truncated request header");
+			}
+			if (c == '\n') {
+				break;
+			}
+			header += c;
+			if (header.size() > 64) {
+				throw std::runtime_error("Request header too long");
+			}
+		}
+		size_t space = header.find(' ');
+		char* end = nullptr;
+		unsigned long long length = space == std::string::npos ? 0 : strtoull(header.c_str() + space + 1, &end, 10);
+		if (space == std::string::npos || end == header.c_str() + space + 1 || *end != '\0' || length > kMaxServeRequest) {
+			throw std::runtime_error("Malformed request header \"" + header + "\"");
+		}
+		request.kind = header.substr(0, space);
+		request.payload.resize(length);
+		if (!ReadFully(fd, request.payload.data(), length)) {
+			throw std::runtime_error("Truncated request payload");
+		}
+		return true;
+	}
+
+	inline bool WriteServeResponse(int fd, const std::string& response) {
+		std::string message = std::to_string(response.size()) + '\n' + response;
+		return WriteFully(fd, message.data(), message.size());
+	}
+
+	//Answers requests in order until the other end closes the connection
+	inline void ServeConnection(int in_fd, int out_fd, int worker, const ServeHandler& handler) {
+		ServeRequest request;
+		try {
+			while (ReadServeRequest(in_fd, request)) {
+				if (!WriteServeResponse(out_fd, handler(worker, request))) {
+					return;
+				}
+			}
+		} catch (const std::runtime_error& e) {
+			std::string response = "{\"error\":\"";
+			for (const char* c = e.what(); *c != '\0'; c++) {
+				if (*c == '"' || *c == '\\') {
+					response += '\\';
+				}
+				response += (unsigned char) *c < 0x20 ? ' ' : *c;
+			}
+			WriteServeResponse(out_fd, response + "\"}\n");
+		}
+	}
+
+	//Listens on a Unix domain socket, or serves stdin and stdout if the path is "-". Each of the worker_count workers
+	//accepts one connection at a time and answers its requests in order, further connections wait in the backlog
+	inline void Serve(const std::string& path, int worker_count, const ServeHandler& handler) {
+		signal(SIGPIPE, SIG_IGN); //a client hanging up should only end its own connection
+		if (path == "-") {
+			ServeConnection(STDIN_FILENO, STDOUT_FILENO, 0, handler);
+			return;
+		}
+
+		sockaddr_un address {};
+		address.sun_family = AF_UNIX;
+		if (path.size() >= sizeof(address.sun_path)) {
+			throw std::runtime_error("Socket path too long: " + path);
+		}
+		strcpy(address.sun_path, path.c_str());
+		int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listener < 0) {
+			throw std::runtime_error("Unable to create socket");
+		}
+		struct stat info;
+		if (stat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+			unlink(path.c_str()); //left behind by a server that was killed
+		}
+		if (bind(listener, (const sockaddr*) &address, sizeof(address)) != 0 || listen(listener, 64) != 0) {
+			close(listener);
+			throw std::runtime_error("Unable to listen on " + path + ": " + strerror(errno));
+		}
+
+		std::vector<std::thread> workers;
+		for (int w = 0; w < std::max(1, worker_count); w++) {
+			workers.emplace_back([&, w]() {
+				while (true) {
+					int connection = accept(listener, nullptr, nullptr);
+					if (connection < 0) {
+						if (errno == EINTR || errno == ECONNABORTED) {
+							continue;
+						}
+						return;
+					}
+					ServeConnection(connection, connection, w, handler);
+					close(connection);
+				}
+			});
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
+		close(listener);
+		unlink(path.c_str());
+	}
+
+#else
+
+	inline void Serve(const std::string& path, int worker_count, const ServeHandler& handler) {
+		throw std::runtime_error("--serve is only supported on POSIX systems");
+	}
+
+#endif
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "compiledlogic.hpp"
+#include "rater.hpp"
+
+//Logic specialized for the start location of a seed. Every seed starting there has the start's waypoint and the
+//ignored macros from the start, so do the macros they alone reach at a rating of 0. Those symbols can never change a
+//rating and are left out of every loadout. Loadouts mentioning a macro that nothing could ever reach are dropped, and
+//so is any loadout needing at least the symbols of another of its entry at no lower difficulty. Rates exactly like the
+//unspecialized logic with EvaluationMode::kFixpoint, with the same symbol and location ids
+namespace RandoRater {
+
+	//Symbols whose rating is 0 for the whole progression of every seed starting at start
+	inline std::vector<char> FreeSymbols(const CompiledLogic& logic, SymbolId start) {
+		EvaluationState state(logic);
+		state.mode = EvaluationMode::kFixpoint;
+		if (start != kNoSymbol) {
+			state.Acquire(start, 0);
+		}
+		SolveMacros(logic, state);
+		std::vector<char> free(logic.ignored.begin(), logic.ignored.end());
+		for (SymbolId symbol = 0; symbol < logic.symbols.size(); symbol++) {
+			free[symbol] = free[symbol] || state.acquired[symbol] == 0;
+		}
+		return free;
+	}
+
+	//Macros that some seed could reach, assuming any item can be placed. The rest have no loadout without such a macro
+	inline std::vector<char> ReachableMacros(const CompiledLogic& logic, const std::vector<char>& free) {
+		const LoadoutTable& table = logic.macro_logic;
+		std::vector<char> reachable(logic.macro_count, 0);
+		for (bool changed = true; changed;) {
+			changed = false;
+			for (SymbolId macro = 0; macro < logic.macro_count; macro++) {
+				for (int l = table.entry_begin[macro]; !reachable[macro] && l < table.entry_begin[macro + 1]; l++) {
+					bool satisfiable = true;
+					for (int s = table.loadout_begin[l]; satisfiable && s < table.loadout_begin[l + 1]; s++) {
+						SymbolId symbol = table.symbols[s];
+						satisfiable = free[symbol] || !logic.IsMacro(symbol) || reachable[symbol];
+					}
+					reachable[macro] = satisfiable || free[macro];
+					changed = changed || reachable[macro];
+				}
+			}
+		}
+		return reachable;
+	}
+
+	//Copies the loadouts of table without free symbols, unsatisfiable loadouts or dominated loadouts. Entries that are
+	//never evaluated (free or unreachable macros) are left empty
+	inline void SpecializeLoadouts(const CompiledLogic& logic, const LoadoutTable& table, bool macros, const std::vector<char>& free,
+		const std::vector<char>& reachable, LoadoutTableBuilder& out) {
+		std::vector<std::vector<SymbolId>> kept; //sorted symbols of the entry's loadouts, empty if dropped
+		std::vector<char> dropped;
+		for (int e = 0; e < table.EntryCount(); e++) {
+			if (!macros || (!free[e] && reachable[e])) {
+				int first = table.entry_begin[e], count = table.entry_begin[e + 1] - first;
+				kept.assign(count, std::vector<SymbolId>());
+				dropped.assign(count, 0);
+				for (int i = 0; i < count; i++) {
+					for (int s = table.loadout_begin[first + i]; s < table.loadout_begin[first + i + 1]; s++) {
+						SymbolId symbol = table.symbols[s];
+						if (logic.IsMacro(symbol) && !free[symbol] && !reachable[symbol]) {
+							dropped[i] = 1;
+						} else if (!free[symbol]) {
+							kept[i].push_back(symbol);
+						}
+					}
+					std::sort(kept[i].begin(), kept[i].end());
+				}
+				for (int i = 0; i < count; i++) {
+					for (int j = 0; j < count && !dropped[i]; j++) { //of two identical loadouts the first one stays
+						dropped[i] = j != i && !dropped[j] && table.difficulties[first + j] <= table.difficulties[first + i]
+							&& (kept[j] != kept[i] || j < i) && std::includes(kept[i].begin(), kept[i].end(), kept[j].begin(), kept[j].end());
+					}
+				}
+				for (int i = 0; i < count; i++) {
+					if (dropped[i]) {
+						continue;
+					}
+					for (int s = table.loadout_begin[first + i]; s < table.loadout_begin[first + i + 1]; s++) { //in their original order
+						if (!free[table.symbols[s]]) {
+							out.symbols.push_back(table.symbols[s]);
+						}
+					}
+					out.difficulties.push_back(table.difficulties[first + i]);
+					out.loadout_begin.push_back((int) out.symbols.size());
+				}
+			}
+			out.entry_begin.push_back((int) out.difficulties.size());
+		}
+	}
+
+	inline CompiledLogic SpecializeLogic(const CompiledLogic& logic, SymbolId start) {
+		std::vector<char> free = FreeSymbols(logic, start);
+		std::vector<char> reachable = ReachableMacros(logic, free);
+		LoadoutTableBuilder macro_logic, location_logic;
+		SpecializeLoadouts(logic, logic.macro_logic, true, free, reachable, macro_logic);
+		SpecializeLoadouts(logic, logic.location_logic, false, free, reachable, location_logic);
+		return RebuildLogic(logic, free, macro_logic, location_logic, HashBytes(&start, sizeof(start), logic.source_hash));
+	}
+
+	//Specialized logic per start location, made the first time a seed starts there. Thread safe
+	class SpecializedLogicCache {
+	public:
+		explicit SpecializedLogicCache(const CompiledLogic& logic) : logic(logic) {}
+
+		SpecializedLogicCache(const SpecializedLogicCache&) = delete;
+		SpecializedLogicCache& operator=(const SpecializedLogicCache&) = delete;
+
+		std::shared_ptr<const CompiledLogic> Get(SymbolId start) {
+			std::lock_guard<std::mutex> guard(lock);
+			auto& res = specialized[start];
+			if (res == nullptr) {
+				res = std::make_shared<const CompiledLogic>(SpecializeLogic(logic, start));
+			}
+			return res;
+		}
+
+		int size() {
+			std::lock_guard<std::mutex> guard(lock);
+			return (int) specialized.size();
+		}
+
+	private:
+		const CompiledLogic& logic;
+		std::mutex lock;
+		std::map<SymbolId, std::shared_ptr<const CompiledLogic>> specialized;
+	};
+
+	//RaterContext rating item randomizer seeds in the fixpoint mode over the logic specialized for their start, with one
+	//context per start seen. Other seeds and modes, and ratings with a report (which names loadouts of the unspecialized
+	//logic), are rated as usual. Not thread safe, every thread needs its own, but they can share a cache
+	class SpecializedRater {
+	public:
+		SpecializedRater(const CompiledLogic& logic, SpecializedLogicCache& cache) : logic(logic), cache(cache), context(logic) {}
+
+		SpecializedRater(const SpecializedRater&) = delete;
+		SpecializedRater& operator=(const SpecializedRater&) = delete;
+
+		SeedRating RateSeed(std::string_view spoiler_log, const EvaluationOptions& options = EvaluationOptions()) {
+			context.ParseSeed(spoiler_log);
+			return RateParsed(options);
+		}
+
+		//RateSeed for a log tokenized ahead of time, see RaterContext::LoadSeed
+		SeedRating RateSeed(const RandoSettings& settings, const std::vector<Item>& items,
+			const std::vector<std::pair<std::string_view, std::string_view>>& transitions, const EvaluationOptions& options = EvaluationOptions()) {
+			context.LoadSeed(settings, items, transitions);
+			return RateParsed(options);
+		}
+
+	private:
+		struct Specialized {
+			std::shared_ptr<const CompiledLogic> logic;
+			std::unique_ptr<RaterContext> context;
+		};
+
+		const CompiledLogic& logic;
+		SpecializedLogicCache& cache;
+		RaterContext context; //parses every log, ids are the same in every specialization
+		std::unordered_map<SymbolId, Specialized> contexts;
+		std::vector<SymbolId> starting_symbols;
+
+		SeedRating RateParsed(const EvaluationOptions& options) {
+			const ParsedSpoilerLog& parsed = context.Parsed();
+			if (parsed.settings.mode != RandoMode::kItem || options.mode != EvaluationMode::kFixpoint || options.report != nullptr) {
+				return context.RateParsed(options);
+			}
+			SymbolId start = logic.symbols.Find(parsed.settings.start_location);
+			Specialized& specialized = contexts[start];
+			if (specialized.context == nullptr) {
+				specialized.logic = cache.Get(start);
+				specialized.context = std::make_unique<RaterContext>(*specialized.logic);
+			}
+			starting_symbols.assign(1, start);
+			return specialized.context->RatePlacements(context.Placements(), starting_symbols, options);
+		}
+	};
+}
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#if defined(RANDORATER_STATS)
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#endif
+
+//Counters, phase timers and trace spans for finding where the rater spends its time. They only exist when built with
+//RANDORATER_STATS defined, otherwise every RANDORATER_ macro below expands to nothing and the rater is unchanged
+namespace RandoRater {
+
+	enum StatCounter {
+		kMacroEvaluations, //calls to EvaluateMacro
+		kMacroCacheHits, //answered from acquired or cache without walking any loadout
+		kMacroCacheMisses, //loadouts walked
+		kUncertainMacros, //failures left unevaluated because they saw an evaluation in progress, so they get evaluated again
+		kLocationEvaluations,
+		kLocationRetries, //checks re-evaluated next step because their failure saw an evaluation in progress
+		kLoadoutsExamined, //macro and location loadouts, including those decided by their masks
+		kProgressionSteps,
+		kStatCounterCount
+	};
+
+	enum StatPhase {
+		kPhaseLoadLogic,
+		kPhaseReadLog,
+		kPhaseParseLog,
+		kPhaseRateProgression,
+		kStatPhaseCount
+	};
+
+#if defined(RANDORATER_STATS)
+
+	inline const char* const kStatCounterNames[kStatCounterCount] = {
+		"macro_evaluations", "macro_cache_hits", "macro_cache_misses", "uncertain_macros", "location_evaluations", "location_retries",
+		"loadouts_examined", "progression_steps"
+	};
+
+	inline const char* const kStatPhaseNames[kStatPhaseCount] = {
+		"load_logic", "read_log", "parse_log", "rate_progression"
+	};
+
+	//Default number of spans each thread keeps, older spans are overwritten once it is full
+	const size_t kTraceCapacity = 1 << 18;
+
+	struct TraceEvent {
+		const char* name;
+		std::string_view detail; //points into the logic image or a literal, so the trace has to be written while it is alive
+		int64_t start_ns;
+		int64_t duration_ns;
+	};
+
+	struct ThreadStats {
+		int thread_index = 0;
+		uint64_t counters[kStatCounterCount] = {};
+		int64_t phase_ns[kStatPhaseCount] = {};
+		std::vector<TraceEvent> trace; //ring buffer, grows up to the capacity and then wraps at trace_next
+		size_t trace_next = 0;
+	};
+
+	//Every thread registers its own ThreadStats on first use and only ever writes to that, so nothing is shared while
+	//rating. Totals and the trace are read once the workers have stopped
+	class StatsRegistry {
+	public:
+		static StatsRegistry& Get() {
+			static StatsRegistry registry;
+			return registry;
+		}
+
+		ThreadStats& Register() {
+			std::lock_guard<std::mutex> guard(lock);
+			threads.push_back(std::make_unique<ThreadStats>());
+			threads.back()->thread_index = (int) threads.size() - 1;
+			return *threads.back();
+		}
+
+		//Has to be called before any thread starts rating
+		void EnableTrace(size_t capacity = kTraceCapacity) {
+			trace_capacity = capacity > 0 ? capacity : 1;
+			trace_enabled = true;
+		}
+
+		static bool TraceEnabled() {
+			return trace_enabled;
+		}
+
+		size_t TraceCapacity() const {
+			return trace_capacity;
+		}
+
+		int64_t Now() const {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		ThreadStats Totals() {
+			std::lock_guard<std::mutex> guard(lock);
+			ThreadStats totals;
+			for (auto& thread : threads) {
+				for (int c = 0; c < kStatCounterCount; c++) {
+					totals.counters[c] += thread->counters[c];
+				}
+				for (int p = 0; p < kStatPhaseCount; p++) {
+					totals.phase_ns[p] += thread->phase_ns[p];
+				}
+			}
+			return totals;
+		}
+
+		//Phase times are summed over threads, so in a batch they can add up to more than the wall time
+		void WriteStats(std::ostream& out) {
+			ThreadStats totals = Totals();
+			for (int p = 0; p < kStatPhaseCount; p++) {
+				out << kStatPhaseNames[p] << "_ms: " << totals.phase_ns[p] / 1e6 << '\n';
+			}
+			for (int c = 0; c < kStatCounterCount; c++) {
+				out << kStatCounterNames[c] << ": " << totals.counters[c] << '\n';
+			}
+			out.flush();
+		}
+
+		//Chrome trace event format, complete ("X") events with microsecond timestamps, one track per thread
+		void WriteTrace(const std::string& path) {
+			std::ofstream out(path, std::ios::binary);
+			if (!out) {
+				throw std::ios_base::failure("Unable to write " + path);
+			}
+			std::lock_guard<std::mutex> guard(lock);
+			out << "{\"traceEvents\":[";
+			bool first = true;
+			for (auto& thread : threads) {
+				size_t count = thread->trace.size();
+				size_t oldest = count < trace_capacity ? 0 : thread->trace_next;
+				for (size_t e = 0; e < count; e++) {
+					const TraceEvent& event = thread->trace[(oldest + e) % count];
+					out << (first ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->thread_index
+						<< ",\"ts\":" << event.start_ns / 1000 << '.' << PaddedNanoseconds(event.start_ns % 1000)
+						<< ",\"dur\":" << event.duration_ns / 1000 << '.' << PaddedNanoseconds(event.duration_ns % 1000);
+					if (!event.detail.empty()) {
+						out << ",\"args\":{\"name\":\"";
+						for (char c : event.detail) {
+							if (c == '"' || c == '\\') {
+								out << '\\';
+							}
+							out << ((unsigned char) c < 0x20 ? ' ' : c);
+						}
+						out << "\"}";
+					}
+					out << '}';
+					first = false;
+				}
+			}
+			out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+			if (!out) {
+				throw std::ios_base::failure("Unable to write " + path);
+			}
+		}
+
+	private:
+		StatsRegistry() : start(std::chrono::steady_clock::now()) {}
+
+		static std::string PaddedNanoseconds(int64_t ns) {
+			std::string digits = std::to_string(ns);
+			return std::string(3 - digits.size(), '0') + digits;
+		}
+
+		std::mutex lock;
+		std::vector<std::unique_ptr<ThreadStats>> threads;
+		std::chrono::steady_clock::time_point start;
+		static inline bool trace_enabled = false;
+		size_t trace_capacity = kTraceCapacity;
+	};
+
+	//Constant initialized, so reaching it costs no guard on every counter
+	inline thread_local ThreadStats* current_thread_stats = nullptr;
+
+	inline ThreadStats& CurrentThreadStats() {
+		if (current_thread_stats == nullptr) {
+			current_thread_stats = &StatsRegistry::Get().Register();
+		}
+		return *current_thread_stats;
+	}
+
+	inline void CountStat(StatCounter counter, uint64_t amount = 1) {
+		CurrentThreadStats().counters[counter] += amount;
+	}
+
+	inline void RecordTraceEvent(const char* name, std::string_view detail, int64_t start_ns, int64_t end_ns) {
+		ThreadStats& stats = CurrentThreadStats();
+		TraceEvent event { name, detail, start_ns, end_ns - start_ns };
+		size_t capacity = StatsRegistry::Get().TraceCapacity();
+		if (stats.trace.size() < capacity) {
+			stats.trace.push_back(event);
+		} else {
+			stats.trace[stats.trace_next] = event;
+		}
+		stats.trace_next = (stats.trace_next + 1) % capacity;
+	}
+
+	//Records a span from construction to destruction when tracing was enabled at the time it started
+	class TraceSpan {
+	public:
+		TraceSpan(const char* name, std::string_view detail = std::string_view()) : name(name), detail(detail),
+			start_ns(StatsRegistry::TraceEnabled() ? StatsRegistry::Get().Now() : -1) {}
+
+		~TraceSpan() {
+			if (start_ns >= 0) {
+				RecordTraceEvent(name, detail, start_ns, StatsRegistry::Get().Now());
+			}
+		}
+
+		TraceSpan(const TraceSpan&) = delete;
+		TraceSpan& operator=(const TraceSpan&) = delete;
+
+	private:
+		const char* name;
+		std::string_view detail;
+		int64_t start_ns;
+	};
+
+	//Adds the time from construction to destruction to a phase and traces it as a span
+	class PhaseTimer {
+	public:
+		PhaseTimer(StatPhase phase) : phase(phase), start_ns(StatsRegistry::Get().Now()) {}
+
+		~PhaseTimer() {
+			int64_t end_ns = StatsRegistry::Get().Now();
+			CurrentThreadStats().phase_ns[phase] += end_ns - start_ns;
+			if (StatsRegistry::TraceEnabled()) {
+				RecordTraceEvent(kStatPhaseNames[phase], std::string_view(), start_ns, end_ns);
+			}
+		}
+
+		PhaseTimer(const PhaseTimer&) = delete;
+		PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+	private:
+		StatPhase phase;
+		int64_t start_ns;
+	};
+
+#define RANDORATER_STATS_CONCAT_(a, b) a##b
+#define RANDORATER_STATS_CONCAT(a, b) RANDORATER_STATS_CONCAT_(a, b)
+#define RANDORATER_COUNT(counter) ::RandoRater::CountStat(::RandoRater::counter)
+#define RANDORATER_COUNT_N(counter, amount) ::RandoRater::CountStat(::RandoRater::counter, (uint64_t) (amount))
+#define RANDORATER_PHASE(phase) ::RandoRater::PhaseTimer RANDORATER_STATS_CONCAT(randorater_phase_, __LINE__)(::RandoRater::phase)
+#define RANDORATER_TRACE(name) ::RandoRater::TraceSpan RANDORATER_STATS_CONCAT(randorater_span_, __LINE__)(name)
+#define RANDORATER_TRACE_DETAIL(name, detail) ::RandoRater::TraceSpan RANDORATER_STATS_CONCAT(randorater_span_, __LINE__)(name, detail)
+
+#else
+
+#define RANDORATER_COUNT(counter) ((void) 0)
+#define RANDORATER_COUNT_N(counter, amount) ((void) 0)
+#define RANDORATER_PHASE(phase) ((void) 0)
+#define RANDORATER_TRACE(name) ((void) 0)
+#define RANDORATER_TRACE_DETAIL(name, detail) ((void) 0)
+
+#endif
+}
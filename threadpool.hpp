@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RandoRater {
+
+	inline int DefaultWorkerCount() {
+		return std::max(1, (int) std::thread::hardware_concurrency());
+	}
+
+	//Calls task(worker, index) for every index in [0, count) across worker_count threads. Every worker starts with its own
+	//contiguous share of the indices and, once that runs out, steals the back half of whichever share has the most left,
+	//so workers stay busy even when a few tasks take much longer than the rest. The first exception thrown by a task is
+	//rethrown once every worker has stopped
+	template <typename Task>
+	void ParallelFor(int count, int worker_count, Task task) {
+		struct Share {
+			std::mutex lock;
+			int begin = 0, end = 0;
+		};
+
+		worker_count = std::max(1, std::min(worker_count, count));
+		std::unique_ptr<Share[]> shares(new Share[worker_count]);
+		for (int w = 0; w < worker_count; w++) {
+			shares[w].begin = (int) ((long long) count * w / worker_count);
+			shares[w].end = (int) ((long long) count * (w + 1) / worker_count);
+		}
+
+		std::mutex error_lock;
+		std::exception_ptr error;
+
+		auto work = [&](int worker) {
+			Share& own = shares[worker];
+			while (true) {
+				int index = -1;
+				{
+					std::lock_guard<std::mutex> guard(own.lock);
+					if (own.begin < own.end) {
+						index = own.begin++;
+					}
+				}
+				if (index < 0) {
+					int victim = -1, most_left = 0;
+					for (int w = 0; w < worker_count; w++) {
+						std::lock_guard<std::mutex> guard(shares[w].lock);
+						if (shares[w].end - shares[w].begin > most_left) {
+							most_left = shares[w].end - shares[w].begin;
+							victim = w;
+						}
+					}
+					if (victim < 0) {
+						return;
+					}
+					std::lock(own.lock, shares[victim].lock);
+					std::lock_guard<std::mutex> own_guard(own.lock, std::adopt_lock), victim_guard(shares[victim].lock, std::adopt_lock);
+					Share& stolen = shares[victim];
+					if (stolen.begin < stolen.end) {
+						int middle = stolen.end - (stolen.end - stolen.begin + 1) / 2;
+						own.begin = middle;
+						own.end = stolen.end;
+						stolen.end = middle;
+					}
+					continue;
+				}
+				try {
+					task(worker, index);
+				} catch (...) {
+					std::lock_guard<std::mutex> guard(error_lock);
+					if (!error) {
+						error = std::current_exception();
+					}
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (int w = 1; w < worker_count; w++) {
+			threads.emplace_back(work, w);
+		}
+		work(0);
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
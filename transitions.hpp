@@ -0,0 +1,489 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <ios>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "pugixml.hpp"
+#include "compiledlogic.hpp"
+
+//Area and room randomizer logic. Doors and the regions they open (waypoints for areas, room macros for rooms) are nodes
+//of a graph whose edges are the logic of areas.xml or rooms.xml plus the transitions a seed placed, and checks hang off
+//the nodes by their areaLogic or roomLogic. Logic is kept as expressions instead of being expanded into loadouts like
+//parsed.xml, a door's logic mentions the other doors of its room and expanding through them never ends
+namespace RandoRater {
+
+	enum class RandoMode {
+		kItem, kArea, kRoom
+	};
+
+	const char* const kXmlDirectory = "XML"; //every path below is in it, relative to the working directory
+
+	//One of the XML paths, moved to another directory
+	inline std::string XmlPathIn(const std::string& xml_directory, const char* path) {
+		return xml_directory + (path + std::char_traits<char>::length(kXmlDirectory));
+	}
+
+	const char* const kAreaTransitionsPath = "XML/areas.xml";
+	const char* const kRoomTransitionsPath = "XML/rooms.xml";
+	const char* const kWaypointsPath = "XML/waypoints.xml";
+	const char* const kMacrosPath = "XML/macros.xml";
+	const char* const kStartLocationsPath = "XML/startlocations.xml";
+	const char* const kFirstRoomMacro = "CANSTAG-R"; //macros.xml has the room macros last, starting with this one
+
+	//Every file with check logic, and the element its checks are written as
+	const std::pair<const char*, const char*> kCheckLogicFiles[] = {
+		{ "XML/items.xml", "item" }, { "XML/rocks.xml", "item" }, { "XML/shops.xml", "shop" }, { "XML/soul_lore.xml", "item" }
+	};
+
+	enum class GraphOp : char {
+		kNode, kSymbol, kNever, kAnd, kOr
+	};
+
+	struct GraphInstruction {
+		GraphOp op;
+		int operand; //node or symbol id
+	};
+
+	//Entries are the nodes, doors first, followed by every location of the compiled logic at node_count + its location id.
+	//Symbol and location ids are those of the compiled logic with source_hash
+	struct TransitionLogic {
+		RandoMode mode = RandoMode::kItem;
+		uint64_t source_hash = 0;
+		std::vector<std::string> node_names;
+		std::unordered_map<std::string, int> node_ids;
+		int door_count = 0;
+		std::vector<signed char> one_way; //per door, 1 if it can only be left through and 2 if it can only be arrived at
+		std::vector<int> code_begin; //postfix logic of entry e is code[code_begin[e], code_begin[e + 1]), empty if never in logic
+		std::vector<GraphInstruction> code;
+		std::vector<int> node_dependent_begin, node_dependents; //entries whose logic mentions each node
+		std::vector<int> symbol_dependent_begin, symbol_dependents; //entries whose logic mentions each symbol
+		std::unordered_map<std::string, int> start_doors; //door each start location (as written in the log) begins at
+
+		int NodeCount() const {
+			return (int) node_names.size();
+		}
+
+		int EntryCount() const {
+			return (int) code_begin.size() - 1;
+		}
+
+		int FindDoor(std::string_view name) const {
+			auto found = node_ids.find(std::string(name));
+			return found == node_ids.end() || found->second >= door_count ? -1 : found->second;
+		}
+	};
+
+	//Recursive descent over the same grammar as logicparser, "+" binding tighter than "|". Names are nodes if the graph
+	//has them and symbols of the compiled logic otherwise, names neither knows can never be acquired
+	class GraphLogicCompiler {
+	public:
+		GraphLogicCompiler(const TransitionLogic& transitions, const CompiledLogic& logic, std::vector<GraphInstruction>& code)
+			: transitions(transitions), logic(logic), code(code) {}
+
+		void Compile(std::string_view new_text) {
+			text = new_text;
+			pos = 0;
+			if (Peek() == 0) {
+				return;
+			}
+			Expression();
+			if (Peek() != 0) {
+				Fail("unexpected \"" + std::string(1, text[pos]) + "\"");
+			}
+		}
+
+	private:
+		const TransitionLogic& transitions;
+		const CompiledLogic& logic;
+		std::vector<GraphInstruction>& code;
+		std::string_view text;
+		size_t pos = 0;
+
+		[[noreturn]] void Fail(const std::string& message) {
+			throw std::logic_error("Malformed logic, " + message + " in \"" + std::string(text) + "\"");
+		}
+
+		char Peek() {
+			while (pos < text.length() && isspace((unsigned char) text[pos])) {
+				pos++;
+			}
+			return pos < text.length() ? text[pos] : 0;
+		}
+
+		void Expression() {
+			Conjunction();
+			while (Peek() == '|') {
+				pos++;
+				Conjunction();
+				code.push_back({ GraphOp::kOr, 0 });
+			}
+		}
+
+		void Conjunction() {
+			Primary();
+			while (Peek() == '+') {
+				pos++;
+				Primary();
+				code.push_back({ GraphOp::kAnd, 0 });
+			}
+		}
+
+		void Primary() {
+			char c = Peek();
+			if (c == '(') {
+				pos++;
+				Expression();
+				if (Peek() != ')') {
+					Fail("missing \")\"");
+				}
+				pos++;
+				return;
+			} else if (c == 0 || c == ')' || c == '+' || c == '|') {
+				Fail(c == 0 ? std::string("missing operand") : "unexpected \"" + std::string(1, c) + "\"");
+			}
+			size_t begin = pos;
+			while (pos < text.length() && !isspace((unsigned char) text[pos]) && std::string_view("+|()").find(text[pos]) == std::string_view::npos) {
+				pos++;
+			}
+			std::string name(text.substr(begin, pos - begin));
+			auto node = transitions.node_ids.find(name);
+			if (node != transitions.node_ids.end()) {
+				code.push_back({ GraphOp::kNode, node->second });
+			} else {
+				SymbolId symbol = logic.symbols.Find(name);
+				code.push_back({ symbol == kNoSymbol ? GraphOp::kNever : GraphOp::kSymbol, symbol });
+			}
+		}
+	};
+
+	inline void BuildGraphDependents(const TransitionLogic& transitions, GraphOp op, int count, std::vector<int>& begin, std::vector<int>& entries) {
+		std::vector<std::vector<int>> dependents(count);
+		for (int e = 0; e < transitions.EntryCount(); e++) {
+			for (int i = transitions.code_begin[e]; i < transitions.code_begin[e + 1]; i++) {
+				const GraphInstruction& instruction = transitions.code[i];
+				if (instruction.op == op && (dependents[instruction.operand].empty() || dependents[instruction.operand].back() != e)) {
+					dependents[instruction.operand].push_back(e);
+				}
+			}
+		}
+		begin.assign(1, 0);
+		entries.clear();
+		for (auto& of : dependents) {
+			entries.insert(entries.end(), of.begin(), of.end());
+			begin.push_back((int) entries.size());
+		}
+	}
+
+	inline pugi::xml_node LoadRandomizerXml(pugi::xml_document& doc, const std::string& path) {
+		if (!doc.load_file(path.c_str())) {
+			throw std::ios_base::failure("Unable to parse " + path);
+		}
+		return doc.child("randomizer");
+	}
+
+	inline TransitionLogic LoadTransitionLogic(const CompiledLogic& logic, RandoMode mode, const std::string& xml_directory = kXmlDirectory) {
+		if (mode == RandoMode::kItem) {
+			throw std::logic_error("Item Randomizer has no transitions");
+		}
+		TransitionLogic res;
+		res.mode = mode;
+		res.source_hash = logic.source_hash;
+		auto add_node = [&](const std::string& name) {
+			if (!res.node_ids.emplace(name, (int) res.node_names.size()).second) {
+				throw std::logic_error("Logic defined twice for " + name);
+			}
+			res.node_names.push_back(name);
+		};
+
+		std::vector<std::string> node_logic;
+		pugi::xml_document doors_doc;
+		pugi::xml_node doors = LoadRandomizerXml(doors_doc, XmlPathIn(xml_directory, mode == RandoMode::kArea ? kAreaTransitionsPath : kRoomTransitionsPath));
+		for (auto door = doors.child("transition"); door; door = door.next_sibling("transition")) {
+			add_node(door.attribute("name").as_string());
+			res.one_way.push_back((signed char) door.child("oneWay").text().as_int());
+			node_logic.push_back(door.child("logic").text().as_string());
+		}
+		res.door_count = res.NodeCount();
+
+		pugi::xml_document regions_doc;
+		if (mode == RandoMode::kArea) {
+			pugi::xml_node waypoints = LoadRandomizerXml(regions_doc, XmlPathIn(xml_directory, kWaypointsPath));
+			for (auto waypoint = waypoints.child("item"); waypoint; waypoint = waypoint.next_sibling("item")) {
+				add_node(waypoint.attribute("name").as_string());
+				node_logic.push_back(waypoint.child("areaLogic").text().as_string());
+			}
+		} else {
+			pugi::xml_node macros = LoadRandomizerXml(regions_doc, XmlPathIn(xml_directory, kMacrosPath));
+			bool room_macro = false;
+			for (auto macro = macros.child("macro"); macro; macro = macro.next_sibling("macro")) {
+				std::string name = macro.attribute("name").as_string();
+				room_macro = room_macro || name == kFirstRoomMacro;
+				if (room_macro) {
+					add_node(name);
+					node_logic.push_back(macro.text().as_string());
+				}
+			}
+		}
+
+		std::vector<std::string> location_logic(logic.locations.size());
+		const char* logic_child = mode == RandoMode::kArea ? "areaLogic" : "roomLogic";
+		for (auto& file : kCheckLogicFiles) {
+			pugi::xml_document checks_doc;
+			pugi::xml_node checks = LoadRandomizerXml(checks_doc, XmlPathIn(xml_directory, file.first));
+			for (auto check = checks.child(file.second); check; check = check.next_sibling(file.second)) {
+				SymbolId location = logic.locations.Find(check.attribute("name").as_string());
+				if (location != kNoSymbol) {
+					location_logic[location] = check.child(logic_child).text().as_string();
+				}
+			}
+		}
+
+		GraphLogicCompiler compiler(res, logic, res.code);
+		res.code_begin.push_back(0);
+		for (int e = 0; e < res.NodeCount() + logic.locations.size(); e++) {
+			const std::string& text = e < res.NodeCount() ? node_logic[e] : location_logic[e - res.NodeCount()];
+			try {
+				compiler.Compile(text);
+			} catch (const std::exception& error) {
+				throw std::logic_error((e < res.NodeCount() ? res.node_names[e] : std::string(logic.locations.Name(e - res.NodeCount()))) + ": " + error.what());
+			}
+			res.code_begin.push_back((int) res.code.size());
+		}
+		BuildGraphDependents(res, GraphOp::kNode, res.NodeCount(), res.node_dependent_begin, res.node_dependents);
+		BuildGraphDependents(res, GraphOp::kSymbol, logic.symbols.size(), res.symbol_dependent_begin, res.symbol_dependents);
+
+		pugi::xml_document starts_doc;
+		pugi::xml_node starts = LoadRandomizerXml(starts_doc, XmlPathIn(xml_directory, kStartLocationsPath));
+		for (auto start = starts.child("start"); start; start = start.next_sibling("start")) {
+			int door = res.FindDoor(start.child(mode == RandoMode::kArea ? "areaTransition" : "roomTransition").text().as_string());
+			if (door >= 0) {
+				res.start_doors[start.attribute("name").as_string()] = door;
+			}
+		}
+		return res;
+	}
+
+	//Transition logic is only read from the XML once per mode and compiled logic, and shared by every rater after that.
+	//Thread safe
+	class TransitionLogicCache {
+	public:
+		explicit TransitionLogicCache(std::string xml_directory = kXmlDirectory) : xml_directory(std::move(xml_directory)) {}
+
+		TransitionLogicCache(const TransitionLogicCache&) = delete;
+		TransitionLogicCache& operator=(const TransitionLogicCache&) = delete;
+
+		std::shared_ptr<const TransitionLogic> Get(const CompiledLogic& logic, RandoMode mode) {
+			std::lock_guard<std::mutex> guard(lock);
+			auto& res = loaded[std::make_pair(logic.source_hash, mode)];
+			if (res == nullptr) {
+				res = std::make_shared<const TransitionLogic>(LoadTransitionLogic(logic, mode, xml_directory));
+			}
+			return res;
+		}
+
+		//Reads from kXmlDirectory, for the programs of this repository
+		static TransitionLogicCache& Process() {
+			static TransitionLogicCache cache;
+			return cache;
+		}
+
+	private:
+		std::string xml_directory;
+		std::mutex lock;
+		std::map<std::pair<uint64_t, RandoMode>, std::shared_ptr<const TransitionLogic>> loaded;
+	};
+
+	inline std::shared_ptr<const TransitionLogic> SharedTransitionLogic(const CompiledLogic& logic, RandoMode mode) {
+		return TransitionLogicCache::Process().Get(logic, mode);
+	}
+
+	//Reachability of one seed's doors, regions and checks as symbols are acquired. Nodes are settled in rating order like
+	//in Dijkstra's algorithm, and once settled their rating never changes, so each acquisition only expands what it opened.
+	//A node's rating is the hardest node its logic needs plus every symbol it needs: items add up like in a loadout, but
+	//nodes share most of their route, so counting each of them in full would double the rating with every room passed.
+	//Checks are never settled, their rating only drops as more of the graph is reached
+	class TransitionGraph {
+	public:
+		std::vector<SymbolId> changed_locations; //locations whose rating dropped since this was last cleared
+
+		TransitionGraph(const CompiledLogic& logic, std::shared_ptr<const TransitionLogic> transitions) : logic(logic),
+			transitions(std::move(transitions)), node_rating(this->transitions->NodeCount()), tentative(this->transitions->NodeCount()),
+			location_rating(logic.locations.size()), exit_begin(this->transitions->door_count + 1) {}
+
+		TransitionGraph(const TransitionGraph&) = delete;
+		TransitionGraph& operator=(const TransitionGraph&) = delete;
+
+		const TransitionLogic& Logic() const {
+			return *transitions;
+		}
+
+		//The seed's transitions as pairs of door ids, each usable both ways unless a door is one way
+		void Place(const std::vector<std::pair<int, int>>& placed, int new_start_door) {
+			start_door = new_start_door;
+			edges.clear();
+			for (auto& pair : placed) {
+				for (int direction = 0; direction < 2; direction++) {
+					int from = direction == 0 ? pair.first : pair.second, to = direction == 0 ? pair.second : pair.first;
+					if (transitions->one_way[from] != 2 && transitions->one_way[to] != 1) {
+						edges.push_back(std::make_pair(from, to));
+					}
+				}
+			}
+			std::sort(edges.begin(), edges.end());
+			edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+			std::fill(exit_begin.begin(), exit_begin.end(), 0);
+			for (auto& edge : edges) {
+				exit_begin[edge.first + 1]++;
+			}
+			for (size_t door = 1; door < exit_begin.size(); door++) {
+				exit_begin[door] += exit_begin[door - 1];
+			}
+		}
+
+		//Back to only the start door reached, with whatever is acquired so far. Every entry is evaluated once
+		void Reset(const std::vector<long long int>& new_acquired) {
+			acquired = &new_acquired;
+			std::fill(node_rating.begin(), node_rating.end(), -1);
+			std::fill(tentative.begin(), tentative.end(), -1);
+			std::fill(location_rating.begin(), location_rating.end(), -1);
+			queue.clear();
+			changed_locations.clear();
+			Lower(start_door, 0);
+			for (int e = 0; e < transitions->EntryCount(); e++) {
+				Reevaluate(e);
+			}
+		}
+
+		//Reevaluates what mentions a symbol that was just acquired, Expand settles what that opened
+		void Acquire(SymbolId symbol) {
+			if (symbol + 1 >= (int) transitions->symbol_dependent_begin.size()) {
+				return;
+			}
+			for (int i = transitions->symbol_dependent_begin[symbol]; i < transitions->symbol_dependent_begin[symbol + 1]; i++) {
+				Reevaluate(transitions->symbol_dependents[i]);
+			}
+		}
+
+		void Expand() {
+			while (!queue.empty()) {
+				std::pop_heap(queue.begin(), queue.end(), std::greater<std::pair<long long int, int>>());
+				auto next = queue.back();
+				queue.pop_back();
+				int node = next.second;
+				if (node_rating[node] >= 0 || tentative[node] != next.first) {
+					continue;
+				}
+				node_rating[node] = next.first;
+				if (node < transitions->door_count) {
+					for (int e = exit_begin[node]; e < exit_begin[node + 1]; e++) {
+						Lower(edges[e].second, next.first);
+					}
+				}
+				for (int i = transitions->node_dependent_begin[node]; i < transitions->node_dependent_begin[node + 1]; i++) {
+					Reevaluate(transitions->node_dependents[i]);
+				}
+			}
+		}
+
+		//-1 if not in logic
+		long long int LocationRating(SymbolId location) const {
+			return location_rating[location];
+		}
+
+	private:
+		//Rating of a part of an expression, split into its hardest node and the sum of its symbols
+		struct Term {
+			long long int node, symbols; //node is -1 if the part is not in logic
+
+			long long int Rating() const {
+				return node < 0 ? -1 : node + symbols;
+			}
+		};
+
+		const CompiledLogic& logic;
+		std::shared_ptr<const TransitionLogic> transitions;
+		const std::vector<long long int>* acquired = nullptr;
+		std::vector<long long int> node_rating; //-1 until settled
+		std::vector<long long int> tentative; //lowest rating seen for each node that is not settled yet, -1 if none
+		std::vector<long long int> location_rating;
+		std::vector<std::pair<int, int>> edges; //(from, to) sorted, the exits of door d are edges[exit_begin[d], exit_begin[d + 1])
+		std::vector<int> exit_begin;
+		int start_door = -1;
+		std::vector<std::pair<long long int, int>> queue; //min-heap of (tentative rating, node)
+		std::vector<Term> stack;
+
+		long long int Evaluate(int entry) {
+			stack.clear();
+			for (int i = transitions->code_begin[entry]; i < transitions->code_begin[entry + 1]; i++) {
+				const GraphInstruction& instruction = transitions->code[i];
+				switch (instruction.op) {
+				case GraphOp::kNode:
+					stack.push_back({ node_rating[instruction.operand], 0 });
+					break;
+				case GraphOp::kSymbol: {
+					long long int rating = logic.ignored[instruction.operand] ? 0 : (*acquired)[instruction.operand];
+					stack.push_back({ rating < 0 ? -1 : 0, std::max(rating, 0ll) });
+					break;
+				}
+				case GraphOp::kNever:
+					stack.push_back({ -1, 0 });
+					break;
+				case GraphOp::kAnd: {
+					Term right = stack.back();
+					stack.pop_back();
+					Term& left = stack.back();
+					left = left.node < 0 || right.node < 0 ? Term { -1, 0 } : Term { std::max(left.node, right.node), left.symbols + right.symbols };
+					break;
+				}
+				case GraphOp::kOr: {
+					Term right = stack.back();
+					stack.pop_back();
+					Term& left = stack.back();
+					if (left.node < 0 || (right.node >= 0 && right.Rating() < left.Rating())) {
+						left = right;
+					}
+					break;
+				}
+				}
+			}
+			return stack.empty() ? -1 : stack.back().Rating();
+		}
+
+		void Lower(int node, long long int rating) {
+			if (node_rating[node] < 0 && (tentative[node] < 0 || rating < tentative[node])) {
+				tentative[node] = rating;
+				queue.push_back(std::make_pair(rating, node));
+				std::push_heap(queue.begin(), queue.end(), std::greater<std::pair<long long int, int>>());
+			}
+		}
+
+		void Reevaluate(int entry) {
+			if (entry < transitions->NodeCount()) {
+				if (node_rating[entry] < 0) {
+					long long int rating = Evaluate(entry);
+					if (rating >= 0) {
+						Lower(entry, rating);
+					}
+				}
+				return;
+			}
+			SymbolId location = entry - transitions->NodeCount();
+			long long int rating = Evaluate(entry);
+			if (rating >= 0 && (location_rating[location] < 0 || rating < location_rating[location])) {
+				location_rating[location] = rating;
+				changed_locations.push_back(location);
+			}
+		}
+	};
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace RandoRater {
+
+	const int kWatchDebounceMs = 200;
+
+#ifdef __linux__
+
+	//Calls on_change whenever the file at path is written, replaced or created, once it has been left alone for
+	//debounce_ms, so a log written in several chunks is only handled once it is complete. The directory is watched rather
+	//than the file, since a file replaced by rename or deleted and written again would lose a watch on the file itself.
+	//Blocks in poll between events and only returns on error
+	inline void WatchFile(const std::string& path, int debounce_ms, const std::function<void()>& on_change) {
+		size_t slash = path.find_last_of('/');
+		std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+		std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+
+		int watcher = inotify_init1(IN_CLOEXEC);
+		if (watcher < 0) {
+			throw std::runtime_error(std::string("Unable to start inotify: ") + strerror(errno));
+		}
+		if (inotify_add_watch(watcher, directory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_MOVED_TO) < 0) {
+			close(watcher);
+			throw std::runtime_error("Unable to watch " + directory + ": " + strerror(errno));
+		}
+
+		alignas(inotify_event) char buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)];
+		bool pending = false;
+		while (true) {
+			pollfd poll_watcher { watcher, POLLIN, 0 };
+			int ready = poll(&poll_watcher, 1, pending ? debounce_ms : -1);
+			if (ready < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				close(watcher);
+				throw std::runtime_error(std::string("Unable to wait for changes: ") + strerror(errno));
+			}
+			if (ready == 0) { //quiet for debounce_ms since the last change
+				pending = false;
+				on_change();
+				continue;
+			}
+			ssize_t length = read(watcher, buffer, sizeof(buffer));
+			if (length < 0) {
+				if (errno == EINTR || errno == EAGAIN) {
+					continue;
+				}
+				close(watcher);
+				throw std::runtime_error(std::string("Unable to read changes: ") + strerror(errno));
+			}
+			for (char* next = buffer; next < buffer + length; ) {
+				const inotify_event* event = (const inotify_event*) next;
+				if (event->len > 0 && name == event->name) {
+					pending = true;
+				}
+				next += sizeof(inotify_event) + event->len;
+			}
+		}
+	}
+
+#else
+
+	inline void WatchFile(const std::string& path, int debounce_ms, const std::function<void()>& on_change) {
+		throw std::runtime_error("--watch is only supported on Linux");
+	}
+
+#endif
+}
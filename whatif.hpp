@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "compiledlogic.hpp"
+#include "rater.hpp"
+
+//Rating of a seed as its placements are edited, for seed editors and local search over placements. Until one of two
+//swapped checks is taken the progression cannot tell the swap happened, so it is replayed from a checkpoint taken at
+//or before that step instead of from the start
+namespace RandoRater {
+
+	class WhatIfRater {
+	public:
+		//A checkpoint every checkpoint_interval progression steps
+		explicit WhatIfRater(const CompiledLogic& logic, int checkpoint_interval = 8) : logic(logic), state(logic), frontier(logic),
+			radiance(FindLocation(logic, "Radiance")), checkpoint_interval(std::max(1, checkpoint_interval)) {}
+
+		WhatIfRater(const WhatIfRater&) = delete;
+		WhatIfRater& operator=(const WhatIfRater&) = delete;
+
+		//Order of placements decides which check is taken when several are equally easy, as for RaterContext
+		void Load(const std::vector<Placement>& new_placements, const std::vector<SymbolId>& new_starting_symbols) {
+			placements = new_placements;
+			starting_symbols = new_starting_symbols;
+			taken_at.assign(placements.size(), -1);
+			taken.clear(); //placements of the last seed, which may have had more of them
+			replay_from = 0;
+			checkpoint_count = 0;
+			remaining = 0;
+			rating = SeedRating();
+		}
+
+		//Loads the item placements of a spoiler log, which has to be of an item randomizer seed
+		void Load(const ParsedSpoilerLog& parsed) {
+			if (parsed.settings.mode != RandoMode::kItem) {
+				throw std::logic_error("Swaps are only rated for Item Randomizer seeds");
+			}
+			std::vector<Placement> new_placements;
+			for (auto& item : parsed.item_locations) { //iteration order of item_locations decides ties, so it is kept
+				new_placements.push_back(MakePlacement(logic, item));
+			}
+			Load(new_placements, { logic.symbols.Find(parsed.settings.start_location) });
+		}
+
+		//Exchanges the items of two placements. Locations and costs stay where they are, and so does source, which keeps
+		//describing the item first placed there
+		void Swap(int placement_a, int placement_b) {
+			if (placement_a == placement_b) {
+				return;
+			}
+			Placement& a = placements.at(placement_a);
+			Placement& b = placements.at(placement_b);
+			std::swap(a.item, b.item);
+			std::swap(a.chain, b.chain);
+			std::swap(a.grub, b.grub);
+			std::swap(a.essence, b.essence);
+			for (int step : { taken_at[placement_a], taken_at[placement_b] }) {
+				if (step >= 0) { //checks never taken before the end changed nothing
+					replay_from = std::min(replay_from, step);
+				}
+			}
+		}
+
+		//Rates progression again from the last checkpoint before the first step a swap since the last rating changed
+		SeedRating Rating() {
+			if (replay_from < kNoReplay) {
+				Replay();
+			}
+			return rating;
+		}
+
+		const std::vector<Placement>& Placements() const {
+			return placements;
+		}
+
+		//Progression step placement was taken at, -1 if it was not taken before the rating was decided
+		int TakenAt(int placement) const {
+			return taken_at.at(placement);
+		}
+
+	private:
+		static const int kNoReplay = 1 << 30;
+
+		//Everything the progression loop changes, as it was at the start of a step
+		struct Checkpoint {
+			std::vector<long long int> acquired;
+			std::vector<uint64_t> available;
+			std::vector<long long int> macro_value;
+			int items_acquired;
+			int step;
+			std::vector<long long int> ratings;
+			std::vector<char> checked, eligible;
+			std::vector<uint64_t> dirty;
+			std::vector<int> dirty_next_step;
+			std::vector<std::pair<long long int, int>> reachable;
+			size_t grubs_unlocked, essence_unlocked;
+			int grub_count, essence_count;
+			size_t remaining;
+			SeedRating rating;
+		};
+
+		const CompiledLogic& logic;
+		EvaluationState state;
+		Frontier frontier;
+		SymbolId radiance;
+		int checkpoint_interval;
+		std::vector<Placement> placements;
+		std::vector<SymbolId> starting_symbols;
+		std::vector<int> taken_at; //per placement
+		std::vector<int> taken; //placement taken at every step
+		std::vector<Checkpoint> checkpoints; //checkpoints[c] is the start of step c * checkpoint_interval
+		int checkpoint_count = 0; //still valid
+		int replay_from = 0; //first step a swap since the last rating may have changed, kNoReplay if none
+		size_t remaining = 0;
+		SeedRating rating;
+
+		void Save(Checkpoint& checkpoint) const {
+			checkpoint.acquired = state.acquired;
+			checkpoint.available = state.available;
+			checkpoint.macro_value = state.macro_value;
+			checkpoint.items_acquired = state.items_acquired;
+			checkpoint.step = state.step;
+			checkpoint.ratings = frontier.ratings;
+			checkpoint.checked = frontier.checked;
+			checkpoint.eligible = frontier.eligible;
+			checkpoint.dirty = frontier.dirty;
+			checkpoint.dirty_next_step = frontier.dirty_next_step;
+			checkpoint.reachable = frontier.reachable;
+			checkpoint.grubs_unlocked = frontier.grubs_unlocked;
+			checkpoint.essence_unlocked = frontier.essence_unlocked;
+			checkpoint.grub_count = frontier.grub_count;
+			checkpoint.essence_count = frontier.essence_count;
+			checkpoint.remaining = remaining;
+			checkpoint.rating = rating;
+		}
+
+		//Macros are only solved with kFixpoint, so the macro cache of the recursive modes never holds anything to restore
+		void Restore(const Checkpoint& checkpoint) {
+			state.acquired = checkpoint.acquired;
+			state.available = checkpoint.available;
+			state.macro_value = checkpoint.macro_value;
+			state.items_acquired = checkpoint.items_acquired;
+			state.step = checkpoint.step;
+			std::fill(state.location_status_stamp.begin(), state.location_status_stamp.end(), -1);
+			frontier.ratings = checkpoint.ratings;
+			frontier.checked = checkpoint.checked;
+			frontier.eligible = checkpoint.eligible;
+			frontier.dirty = checkpoint.dirty;
+			frontier.dirty_next_step = checkpoint.dirty_next_step;
+			frontier.reachable = checkpoint.reachable;
+			frontier.grubs_unlocked = checkpoint.grubs_unlocked;
+			frontier.essence_unlocked = checkpoint.essence_unlocked;
+			frontier.grub_count = checkpoint.grub_count;
+			frontier.essence_count = checkpoint.essence_count;
+			frontier.pass_position = -1;
+			remaining = checkpoint.remaining;
+			rating = checkpoint.rating;
+		}
+
+		//The progression loop of RaterContext with EvaluationMode::kFixpoint, from the latest checkpoint still valid
+		void Replay() {
+			RANDORATER_PHASE(kPhaseRateProgression);
+			int resume = std::min(replay_from / checkpoint_interval, checkpoint_count - 1);
+			if (resume < 0) {
+				state.Reset(logic);
+				state.mode = EvaluationMode::kFixpoint;
+				for (SymbolId symbol : starting_symbols) {
+					if (symbol != kNoSymbol) {
+						state.Acquire(symbol, 0);
+					}
+				}
+				frontier.Reset(placements, state);
+				remaining = placements.size();
+				rating = SeedRating();
+				SolveMacros(logic, state);
+				resume = 0;
+				checkpoint_count = 0;
+			} else {
+				Restore(checkpoints[resume]);
+				checkpoint_count = resume + 1;
+			}
+
+			int step = resume * checkpoint_interval;
+			for (size_t s = step; s < taken.size(); s++) {
+				taken_at[taken[s]] = -1;
+			}
+			taken.resize(step);
+			replay_from = kNoReplay;
+			do {
+				if (step % checkpoint_interval == 0 && step / checkpoint_interval == checkpoint_count) {
+					if (checkpoint_count == (int) checkpoints.size()) {
+						checkpoints.emplace_back();
+					}
+					Save(checkpoints[checkpoint_count++]);
+				}
+				RANDORATER_COUNT(kProgressionSteps);
+				frontier.EvaluateDirty();
+				int next_check = frontier.NextCheck();
+				if (next_check < 0) { //nothing left in logic, so the seed cannot be completed
+					return;
+				}
+				taken_at[next_check] = step++;
+				taken.push_back(next_check);
+				SymbolId item_at_check = frontier.Take(next_check);
+				remaining--;
+				rating.checks_taken++;
+				if (item_at_check != kNoSymbol) {
+					state.Acquire(item_at_check, frontier.ratings[next_check]);
+					frontier.OnAcquire(item_at_check);
+					SolveMacros(logic, state);
+				}
+				rating.raw = EvaluateLocation(radiance, logic, state);
+				frontier.EndStep();
+			} while (remaining > 0 && rating.raw == -1);
+		}
+	};
+}